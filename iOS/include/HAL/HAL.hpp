@@ -10,11 +10,14 @@
 #define _HAL_HPP_
 
 #include "HAL/JSContextGroup.hpp"
+#include "HAL/JSContextGroupExecutor.hpp"
 #include "HAL/JSContext.hpp"
+#include "HAL/JSContextView.hpp"
 
 #include "HAL/JSExport.hpp"
 #include "HAL/JSExportObject.hpp"
 #include "HAL/JSClass.hpp"
+#include "HAL/JSLazyClassInstaller.hpp"
 
 #include "HAL/JSString.hpp"
 
@@ -23,14 +26,25 @@
 #include "HAL/JSNull.hpp"
 #include "HAL/JSBoolean.hpp"
 #include "HAL/JSNumber.hpp"
+#include "HAL/JSValueHandle.hpp"
 
 #include "HAL/JSObject.hpp"
 #include "HAL/JSArray.hpp"
 #include "HAL/JSDate.hpp"
 #include "HAL/JSError.hpp"
 #include "HAL/JSFunction.hpp"
+#include "HAL/JSFunctionCache.hpp"
+#include "HAL/JSGCScheduler.hpp"
+#include "HAL/JSLeakDetector.hpp"
 #include "HAL/JSRegExp.hpp"
 
 #include "HAL/JSPropertyNameArray.hpp"
+#include "HAL/JSPropertyView.hpp"
+#include "HAL/JSResult.hpp"
+
+#include "HAL/JSONWriter.hpp"
+#include "HAL/JSReflect.hpp"
+#include "HAL/JSScriptBundle.hpp"
+#include "HAL/JSModuleLoader.hpp"
 
 #endif // _HAL_HPP_
@@ -48,13 +48,16 @@ public:
     /*!
      @method
      
-     @abstract Return an array of std::shared_ptr<T> to this object's private data.
+     @abstract Return an array of pointers to the private data of this
+     JSArray's items, as returned by JSObject::GetPrivate<T>.
      
-     @result An array of std::shared_ptr<T> to this object's private data if the
-     object has private data of type T*, otherwise nullptr.
+     @result An array of pointers to the items' private data, with
+     nullptr for each item that isn't an object with private data of
+     type T. The pointers are valid for as long as the items are
+     reachable from this JSArray.
      */
     template<typename T>
-    std::vector<std::shared_ptr<T>> GetPrivateItems() const HAL_NOEXCEPT;
+    std::vector<T*> GetPrivateItems() const HAL_NOEXCEPT;
 
 private:
 
@@ -71,9 +74,9 @@ private:
 };
 
 template<typename T>
-std::vector<std::shared_ptr<T>> JSArray::GetPrivateItems() const HAL_NOEXCEPT {
+std::vector<T*> JSArray::GetPrivateItems() const HAL_NOEXCEPT {
 	const uint32_t length = static_cast<uint32_t>(GetProperty("length"));
-	std::vector<std::shared_ptr<T>> items(length);
+	std::vector<T*> items(length);
 	for (uint32_t i = 0; i < length; i++) {
 		const JSValue js_item_prop = GetProperty(i);
 		if (js_item_prop.IsObject()) {
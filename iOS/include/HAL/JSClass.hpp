@@ -24,6 +24,9 @@ namespace HAL { namespace detail {
   
   template<typename T>
   class JSExportClassDefinitionBuilder;
+  
+  template<typename T>
+  class JSExportClass;
 }}
 
 namespace HAL {
@@ -84,7 +87,7 @@ namespace HAL {
     
   private:
     
-    // These five classes need access to operator JSClassRef().
+    // These six classes need access to operator JSClassRef().
     friend class JSContext; // for constructor
     friend class JSValue;   // for IsObjectOfClass
     friend class JSObject;  // for constructor
@@ -97,6 +100,10 @@ namespace HAL {
     template<typename T>
     friend class detail::JSExportClassDefinitionBuilder;
     
+    // For recording the JSClassRef of each JSExport class.
+    template<typename T>
+    friend class detail::JSExportClass;
+    
     explicit operator JSClassRef() const HAL_NOEXCEPT {
       return js_class_ref__;
     }
@@ -109,15 +116,10 @@ namespace HAL {
     JSClassRef  js_class_ref__ { nullptr };
 #pragma warning(pop)
     
-  protected:
-    
+    // A JSClassRef may be used on any thread, so there is nothing to
+    // check.
 #undef  HAL_JSCLASS_LOCK_GUARD
-#ifdef  HAL_THREAD_SAFE
-    std::recursive_mutex mutex__;
-#define HAL_JSCLASS_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock(mutex__)
-#else
 #define HAL_JSCLASS_LOCK_GUARD
-#endif  // HAL_THREAD_SAFE
   };
   
   inline
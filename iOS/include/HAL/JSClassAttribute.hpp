@@ -9,7 +9,10 @@
 #ifndef _HAL_JSCLASSATTRIBUTE_HPP_
 #define _HAL_JSCLASSATTRIBUTE_HPP_
 
+#include "HAL/detail/JSBase.hpp"
+
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace HAL {
@@ -29,6 +32,72 @@ enum class HAL_EXPORT JSClassAttribute : std::uint32_t /* typedef unsigned JSCla
 	NoAutomaticPrototype
 };
 
+/*!
+  @class
+  
+  @discussion A JSClassAttributes is a set of JSClassAttribute values
+  represented as a bitmask with the same layout as the JavaScriptCore
+  C API JSClassAttributes, so converting between the two has no
+  cost. It is implicitly constructible from a single JSClassAttribute.
+*/
+class JSClassAttributes final {
+	
+public:
+	
+	constexpr JSClassAttributes() HAL_NOEXCEPT
+	: js_class_attributes__(kJSClassAttributeNone) {
+	}
+	
+	constexpr JSClassAttributes(JSClassAttribute attribute) HAL_NOEXCEPT
+	: js_class_attributes__(ToBit(attribute)) {
+	}
+	
+	// For interoperability with the JavaScriptCore C API.
+	explicit constexpr JSClassAttributes(::JSClassAttributes js_class_attributes) HAL_NOEXCEPT
+	: js_class_attributes__(js_class_attributes) {
+	}
+	
+	// For interoperability with the JavaScriptCore C API.
+	explicit constexpr operator ::JSClassAttributes() const HAL_NOEXCEPT {
+		return js_class_attributes__;
+	}
+	
+	/*!
+	  @method
+	  
+	  @abstract Return true if the given attribute is in this set.
+	  JSClassAttribute::None is in every set.
+	*/
+	constexpr bool Has(JSClassAttribute attribute) const HAL_NOEXCEPT {
+		return (js_class_attributes__ & ToBit(attribute)) == ToBit(attribute);
+	}
+	
+	constexpr JSClassAttributes operator|(JSClassAttributes rhs) const HAL_NOEXCEPT {
+		return JSClassAttributes(js_class_attributes__ | rhs.js_class_attributes__);
+	}
+	
+	JSClassAttributes& operator|=(JSClassAttributes rhs) HAL_NOEXCEPT {
+		js_class_attributes__ |= rhs.js_class_attributes__;
+		return *this;
+	}
+	
+	constexpr bool operator==(JSClassAttributes rhs) const HAL_NOEXCEPT {
+		return js_class_attributes__ == rhs.js_class_attributes__;
+	}
+	
+	constexpr bool operator!=(JSClassAttributes rhs) const HAL_NOEXCEPT {
+		return js_class_attributes__ != rhs.js_class_attributes__;
+	}
+	
+private:
+	
+	static constexpr ::JSClassAttributes ToBit(JSClassAttribute attribute) HAL_NOEXCEPT {
+		return attribute == JSClassAttribute::NoAutomaticPrototype ? kJSClassAttributeNoAutomaticPrototype : kJSClassAttributeNone;
+	}
+	
+	::JSClassAttributes js_class_attributes__;
+};
+
 } // HAL
 
 // Provide a hash function so that a JSClassAttributes can be stored
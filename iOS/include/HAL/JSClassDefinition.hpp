@@ -100,13 +100,10 @@ namespace HAL {
     ::JSClassDefinition                   js_class_definition__;
 #pragma warning(pop)
     
+    // A JSClassDefinition isn't changed once built, so there is nothing
+    // to check.
 #undef  HAL_JSCLASSDEFINITION_LOCK_GUARD
-#ifdef  HAL_THREAD_SAFE
-    std::recursive_mutex mutex__;
-#define HAL_JSCLASSDEFINITION_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock(mutex__)
-#else
 #define HAL_JSCLASSDEFINITION_LOCK_GUARD
-#endif  // HAL_THREAD_SAFE
   };
   
   inline
@@ -14,6 +14,7 @@
 
 #include <vector>
 #include <unordered_map>
+#include <type_traits>
 
 namespace HAL {
   
@@ -32,10 +33,19 @@ namespace HAL {
   class JSFunction;
   class JSExportObject;
   
+  template<typename T>
+  class JSResult;
+  
   namespace detail {
     template<typename T>
     class JSExportClass;
     
+    template<typename T, typename Enable>
+    struct JSValueConverter;
+    
+    template<typename Callable, typename Enable>
+    struct JSNativeFunctionTraits;
+    
     HAL_EXPORT std::vector<JSValue> to_vector(const JSContext&, size_t, const JSValueRef[]);
   }}
 
@@ -313,6 +323,35 @@ namespace HAL {
     JSFunction CreateFunction(const JSString& body, const std::vector<JSString>& parameter_names, const JSString& function_name) const;
     JSFunction CreateFunction(const JSString& body, const std::vector<JSString>& parameter_names, const JSString& function_name, const JSString& source_url, int starting_line_number = 1) const;
     
+    /*!
+     @method
+     
+     @abstract Create a JavaScript function implemented by a C++
+     callable, such as a lambda or a function pointer, without
+     defining a JSExport class.
+     
+     @discussion The arguments and the return value are converted
+     with JSValueConverter according to the callable's signature, so
+     the callable can take and return bool, the arithmetic types,
+     std::string, JSString, JSValue, JSObject, std::vector of those, and
+     types described by HAL_REFLECT. For example:
+     
+     auto add = js_context.CreateFunction([](double x, double y) { return x + y; });
+     
+     Missing arguments are converted from undefined. A C++ exception
+     thrown by the callable is thrown into JavaScript as an Error. The
+     callable is moved or copied into the function object and
+     destroyed when the function is garbage collected.
+     
+     @param callable The C++ callable that implements the function. It
+     must have exactly one operator().
+     
+     @result A JSObject that is a function. The object's prototype
+     will be the default function prototype.
+     */
+    template<typename Callable, typename = typename detail::JSNativeFunctionTraits<typename std::decay<Callable>::type, void>::result_type>
+    JSObject CreateFunction(Callable&& callable) const;
+    
     
     /* Script Evaluation */
     
@@ -347,6 +386,45 @@ namespace HAL {
     JSValue JSEvaluateScript(const JSString& script,                       const JSString& source_url, int starting_line_number = 1) const;
     JSValue JSEvaluateScript(const JSString& script, JSObject this_object, const JSString& source_url, int starting_line_number = 1) const;
     
+    /*!
+     @method
+     
+     @abstract Evaluate a string of JavaScript code with a this_object
+     of a class derived from JSObject, such as JSArray or JSFunction,
+     without copying it.
+     
+     @discussion The overloads above take this_object by value, so a
+     derived this_object would be sliced into a copy of a JSObject.
+     These are a better match for it and pass it on by reference.
+     Passing a JSObject itself still calls the overloads above, which
+     move it if it is an rvalue.
+     
+     @throws std::runtime_error exception if the evaluated script
+     threw an exception.
+     */
+    template<typename U, typename = typename std::enable_if<std::is_base_of<JSObject, U>::value>::type>
+    JSValue JSEvaluateScript(const JSString& script, const U& this_object) const;
+    template<typename U, typename = typename std::enable_if<std::is_base_of<JSObject, U>::value>::type>
+    JSValue JSEvaluateScript(const JSString& script, const U& this_object, const JSString& source_url, int starting_line_number = 1) const;
+    
+    /*!
+     @method
+     
+     @abstract Evaluate a string of JavaScript code, returning rather
+     than throwing a JavaScript exception.
+     
+     @discussion The parameters have the same meaning as for
+     JSEvaluateScript.
+     
+     @result A JSResult holding the JSValue that results from
+     evaluating script, or a JSNativeError holding the exception if
+     the evaluated script threw one.
+     */
+    JSResult<JSValue> TryEvaluateScript(const JSString& script                                                                                       ) const;
+    JSResult<JSValue> TryEvaluateScript(const JSString& script, const JSObject& this_object                                                          ) const;
+    JSResult<JSValue> TryEvaluateScript(const JSString& script,                              const JSString& source_url, int starting_line_number = 1) const;
+    JSResult<JSValue> TryEvaluateScript(const JSString& script, const JSObject& this_object, const JSString& source_url, int starting_line_number = 1) const;
+    
     /*!
      @method
      
@@ -435,6 +513,12 @@ namespace HAL {
     friend class JSRegExp;
     friend class JSFunction;
     friend class JSPropertyNameArray;
+    friend class JSPropertyView;
+    friend class JSONWriter;
+    friend class JSFunctionCache;
+    friend class JSLeakDetector;
+    friend class JSScriptBundle;
+    friend class JSModuleLoader;
     
     HAL_EXPORT friend bool operator==(const JSValue& lhs, const JSValue& rhs) HAL_NOEXCEPT;
     HAL_EXPORT friend std::vector<JSValue> detail::to_vector(const JSContext&, size_t, const JSValueRef[]);
@@ -444,11 +528,22 @@ namespace HAL {
       return js_global_context_ref__;
     }
     
-    // Only the JSExportClass static functions create a
-    // JSContext using the following constructor.
+    // Only the JSExportClass static functions, JSONWriter,
+    // JSValueConverter, JSValueHandle, JSContextView and JSNativeError
+    // create a JSContext using the following constructors.
     template<typename T>
     friend class detail::JSExportClass;
     
+    template<typename T, typename Enable>
+    friend struct detail::JSValueConverter;
+    
+    friend class JSValueHandle;
+    friend class JSContextView;
+    friend class JSNativeError;
+    
+    // For checking the thread JSExportObject is used on.
+    friend class JSExportObject;
+    
     explicit JSContext(JSContextRef js_context_ref) HAL_NOEXCEPT;
     
     // For interoperability with the JavaScriptCore C API.
@@ -468,13 +563,10 @@ namespace HAL {
     JSGlobalContextRef js_global_context_ref__ { nullptr };
 #pragma warning(pop)
     
+    // A JSContext belongs to the thread of its group's executor, so it
+    // doesn't lock. Debug builds check the calling thread.
 #undef  HAL_JSCONTEXT_LOCK_GUARD
-#ifdef  HAL_THREAD_SAFE
-    std::recursive_mutex mutex__;
-#define HAL_JSCONTEXT_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock(mutex__)
-#else
-#define HAL_JSCONTEXT_LOCK_GUARD
-#endif  // HAL_THREAD_SAFE
+#define HAL_JSCONTEXT_LOCK_GUARD HAL_DETAIL_JSTHREADCONFINEMENT_CHECK(js_global_context_ref__)
   };
   
   inline
@@ -10,6 +10,7 @@
 #define _HAL_JSCONTEXTGROUP_HPP_
 
 #include "HAL/detail/JSBase.hpp"
+#include "HAL/detail/JSExecutorQueue.hpp"
 
 #include <utility>
 
@@ -17,6 +18,7 @@ namespace HAL {
   
   class JSContext;
   class JSClass;
+  class JSContextGroupExecutor;
   
   /*!
    @class
@@ -30,7 +32,9 @@ namespace HAL {
    exchange their JavaScript objects with one another.
    
    When JavaScript objects within the same context group are used in
-   multiple threads, explicit synchronization is required.
+   multiple threads, explicit synchronization is required. The simplest
+   way to provide it is to bind the group to a JSContextGroupExecutor
+   and reach it from other threads with Post and Invoke.
    
    JSContextGroups are the only way to create a JSContext which
    represents a JavaScript execution context.
@@ -77,6 +81,31 @@ namespace HAL {
     JSContext CreateContext() const HAL_NOEXCEPT;
     JSContext CreateContext(const JSClass& global_object_class) const HAL_NOEXCEPT;
     
+    /*!
+     @method
+     
+     @abstract Run a callable on the thread of the JSContextGroupExecutor
+     this group is bound to, and return without waiting for it.
+     
+     @throws std::runtime_error if the group isn't bound to a
+     JSContextGroupExecutor.
+     */
+    template<typename Callable>
+    void Post(Callable&& callable) const;
+    
+    /*!
+     @method
+     
+     @abstract Run a callable on the thread of the JSContextGroupExecutor
+     this group is bound to, and return its result. When called on that
+     thread the callable runs immediately.
+     
+     @throws Whatever the callable throws, or std::runtime_error if the
+     group isn't bound to a JSContextGroupExecutor.
+     */
+    template<typename Callable>
+    detail::JSInvokeResult_t<Callable> Invoke(Callable&& callable) const;
+    
     ~JSContextGroup()                         HAL_NOEXCEPT;
     JSContextGroup(const JSContextGroup&)     HAL_NOEXCEPT;
     JSContextGroup(JSContextGroup&&)          HAL_NOEXCEPT;
@@ -90,6 +119,7 @@ namespace HAL {
     
     // JSContext needs access to operator JSContextGroupRef().
     friend class JSContext;
+    friend class JSContextGroupExecutor;
     
     explicit operator JSContextGroupRef() const HAL_NOEXCEPT {
       return js_context_group_ref__;
@@ -108,13 +138,10 @@ namespace HAL {
     JSContextGroupRef js_context_group_ref__;
 #pragma warning(pop)
     
-#undef HAL_JSCONTEXTGROUP_LOCK_GUARD
-#ifdef HAL_THREAD_SAFE
-    std::recursive_mutex mutex__;
-#define HAL_JSCONTEXTGROUP_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock(mutex__)
-#else
+    // A JSContextGroupRef may be used on any thread, so there is
+    // nothing to check.
+#undef  HAL_JSCONTEXTGROUP_LOCK_GUARD
 #define HAL_JSCONTEXTGROUP_LOCK_GUARD
-#endif  // HAL_THREAD_SAFE
   };
   
   inline
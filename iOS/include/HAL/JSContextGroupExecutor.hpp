@@ -0,0 +1,190 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSCONTEXTGROUPEXECUTOR_HPP_
+#define _HAL_JSCONTEXTGROUPEXECUTOR_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContextGroup.hpp"
+#include "HAL/detail/JSExecutorQueue.hpp"
+#include "HAL/detail/JSThreadConfinement.hpp"
+#include "HAL/detail/JSUtil.hpp"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSContextGroupExecutor binds a JSContextGroup to a
+   thread of its own. While it exists, the group's contexts and
+   everything created in them belong to that thread, so HAL doesn't
+   lock them. Other threads reach the group with
+   JSContextGroup::Post, which runs a task on the executor thread and
+   returns immediately, or JSContextGroup::Invoke, which runs a task
+   on the executor thread and returns its result.
+
+   For example:
+
+   JSContextGroup js_context_group;
+   JSContextGroupExecutor executor(js_context_group);
+   const auto result = js_context_group.Invoke([&js_context_group] {
+     auto js_context = js_context_group.CreateContext();
+     return static_cast<double>(js_context.JSEvaluateScript("6 * 7"));
+   });
+
+   In debug builds every operation on a JSValue, JSObject or JSContext
+   of a bound group asserts that it runs on the executor thread.
+
+   Destroying the executor runs the tasks already posted, joins the
+   thread and unbinds the group. Every value created on the executor
+   thread must be released there, and the executor must not be
+   destroyed by one of its own tasks.
+   */
+  class JSContextGroupExecutor final HAL_PERFORMANCE_COUNTER1(JSContextGroupExecutor) {
+
+  public:
+
+    using Task = detail::JSExecutorQueue::Task;
+
+    /*!
+     @method
+
+     @abstract Start a thread and bind the given group to it.
+
+     @throws std::runtime_error if the group is already bound to an
+     executor.
+     */
+    explicit JSContextGroupExecutor(const JSContextGroup& js_context_group)
+    : js_context_group__(js_context_group)
+    , queue__(std::make_shared<detail::JSExecutorQueue>()) {
+      const auto js_context_group_ref = static_cast<JSContextGroupRef>(js_context_group__);
+      if (detail::JSThreadConfinement::Find(js_context_group_ref)) {
+        detail::ThrowRuntimeError("JSContextGroupExecutor", "JSContextGroup is already bound to an executor");
+      }
+      const auto queue = queue__;
+      thread__ = std::thread([queue, js_context_group_ref] {
+        detail::JSThreadConfinement::SetCurrentGroup(js_context_group_ref);
+        queue -> Run();
+        detail::JSThreadConfinement::SetCurrentGroup(nullptr);
+      });
+      queue__ -> set_thread_id(thread__.get_id());
+      detail::JSThreadConfinement::Bind(js_context_group_ref, thread__.get_id(), queue__);
+    }
+
+    ~JSContextGroupExecutor() HAL_NOEXCEPT {
+      queue__ -> Close();
+      thread__.join();
+      detail::JSThreadConfinement::Unbind(static_cast<JSContextGroupRef>(js_context_group__));
+    }
+
+    /*!
+     @method
+
+     @abstract Run a task on the executor thread and return without
+     waiting for it. Tasks run in the order they were posted.
+     */
+    void Post(Task task) const {
+      Post(*queue__, std::move(task));
+    }
+
+    /*!
+     @method
+
+     @abstract Run a callable on the executor thread and return its
+     result. When called on the executor thread the callable runs
+     immediately.
+
+     @throws Whatever the callable throws, std::runtime_error if the
+     executor is being destroyed, or std::future_error if the task was
+     dropped without running.
+     */
+    template<typename Callable>
+    detail::JSInvokeResult_t<Callable> Invoke(Callable&& callable) const {
+      return Invoke(*queue__, std::forward<Callable>(callable));
+    }
+
+    /*!
+     @method
+
+     @abstract Return true if the calling thread is the executor
+     thread.
+     */
+    bool IsCurrentThread() const HAL_NOEXCEPT {
+      return queue__ -> IsCurrentThread();
+    }
+
+    JSContextGroup get_context_group() const HAL_NOEXCEPT {
+      return js_context_group__;
+    }
+
+    JSContextGroupExecutor(const JSContextGroupExecutor&)            = delete;
+    JSContextGroupExecutor& operator=(const JSContextGroupExecutor&) = delete;
+
+  private:
+
+    // JSContextGroup::Post and JSContextGroup::Invoke find the queue
+    // through JSThreadConfinement.
+    friend class JSContextGroup;
+
+    static void Post(detail::JSExecutorQueue& queue, Task task) {
+      if (!queue.Push(std::move(task))) {
+        HAL_LOG_WARN("JSContextGroupExecutor: executor is being destroyed, task dropped");
+      }
+    }
+
+    template<typename Callable>
+    static detail::JSInvokeResult_t<Callable> Invoke(detail::JSExecutorQueue& queue, Callable&& callable) {
+      if (queue.IsCurrentThread()) {
+        return callable();
+      }
+      using Result = detail::JSInvokeResult_t<Callable>;
+      auto task   = std::make_shared<std::packaged_task<Result()>>(std::forward<Callable>(callable));
+      auto future = task -> get_future();
+      // Only the queued task may own the packaged_task, so that
+      // dropping the task unrun breaks the promise instead of leaving
+      // future.get() blocked.
+      Task queued_task = [task] { (*task)(); };
+      task.reset();
+      if (!queue.Push(std::move(queued_task))) {
+        detail::ThrowRuntimeError("JSContextGroupExecutor", "executor is being destroyed");
+      }
+      return future.get();
+    }
+
+    JSContextGroup                           js_context_group__;
+    std::shared_ptr<detail::JSExecutorQueue> queue__;
+    std::thread                              thread__;
+  };
+
+  template<typename Callable>
+  void JSContextGroup::Post(Callable&& callable) const {
+    const auto queue = detail::JSThreadConfinement::Find(js_context_group_ref__);
+    if (!queue) {
+      detail::ThrowRuntimeError("JSContextGroup", "JSContextGroup is not bound to a JSContextGroupExecutor");
+    }
+    JSContextGroupExecutor::Post(*queue, std::forward<Callable>(callable));
+  }
+
+  template<typename Callable>
+  detail::JSInvokeResult_t<Callable> JSContextGroup::Invoke(Callable&& callable) const {
+    const auto queue = detail::JSThreadConfinement::Find(js_context_group_ref__);
+    if (!queue) {
+      detail::ThrowRuntimeError("JSContextGroup", "JSContextGroup is not bound to a JSContextGroupExecutor");
+    }
+    return JSContextGroupExecutor::Invoke(*queue, std::forward<Callable>(callable));
+  }
+
+} // namespace HAL {
+
+#endif // _HAL_JSCONTEXTGROUPEXECUTOR_HPP_
@@ -0,0 +1,100 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSCONTEXTVIEW_HPP_
+#define _HAL_JSCONTEXTVIEW_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+
+#include <type_traits>
+
+namespace HAL { namespace detail {
+  template<typename T>
+  class JSExportClass;
+}}
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSContextView is a borrowed, non-owning reference to
+   a JavaScript execution context. Unlike a JSContext, copying a
+   JSContextView doesn't retain anything, so it is suitable for passing
+   a context around inside a callback or another short-lived scope.
+
+   A JSContextView must not outlive the JSContext it was created from.
+   Call Promote() to get an owning JSContext when one is needed, for
+   example to create JavaScript values.
+   */
+  class JSContextView final {
+
+  public:
+
+    /*!
+     @method
+
+     @abstract Borrow the given JSContext without retaining it.
+     */
+    JSContextView(const JSContext& js_context) HAL_NOEXCEPT
+    : js_global_context_ref__(JSContextGetGlobalContext(static_cast<JSContextRef>(js_context))) {
+    }
+
+    /*!
+     @method
+
+     @abstract Return an owning JSContext for this execution context.
+     */
+    JSContext Promote() const HAL_NOEXCEPT {
+      return JSContext(js_global_context_ref__);
+    }
+
+    explicit operator JSContext() const HAL_NOEXCEPT {
+      return Promote();
+    }
+
+  private:
+
+    // The JSExportClass static functions borrow the JSContextRef they
+    // are called with.
+    template<typename T>
+    friend class detail::JSExportClass;
+
+    friend bool operator==(const JSContextView& lhs, const JSContextView& rhs) HAL_NOEXCEPT;
+
+    // For interoperability with the JavaScriptCore C API.
+    explicit JSContextView(JSContextRef js_context_ref) HAL_NOEXCEPT
+    : js_global_context_ref__(JSContextGetGlobalContext(js_context_ref)) {
+    }
+
+    // For interoperability with the JavaScriptCore C API.
+    explicit operator JSContextRef() const HAL_NOEXCEPT {
+      return js_global_context_ref__;
+    }
+
+    JSGlobalContextRef js_global_context_ref__;
+  };
+
+  static_assert(std::is_trivially_copyable<JSContextView>::value, "A JSContextView must be trivially copyable");
+
+  // Return true if the two JSContextViews refer to the same execution
+  // context.
+  inline
+  bool operator==(const JSContextView& lhs, const JSContextView& rhs) HAL_NOEXCEPT {
+    return lhs.js_global_context_ref__ == rhs.js_global_context_ref__;
+  }
+
+  inline
+  bool operator!=(const JSContextView& lhs, const JSContextView& rhs) HAL_NOEXCEPT {
+    return ! (lhs == rhs);
+  }
+
+} // namespace HAL {
+
+#endif // _HAL_JSCONTEXTVIEW_HPP_
@@ -11,7 +11,9 @@
 
 #include "HAL/detail/JSBase.hpp"
 #include "HAL/detail/JSExportClassDefinitionBuilder.hpp"
+#include "HAL/detail/JSExportPrivateData.hpp"
 
+#include <cstddef>
 #include <string>
 #include <memory>
 #include <mutex>
@@ -117,6 +119,101 @@ namespace HAL {
      */
     static detail::JSExportClass<T> Class();
     
+    /*!
+     @method
+     
+     @abstract Return the number of bytes of extra memory reported for
+     the live native objects of class T.
+     
+     @discussion Extra memory is reported with
+     JSExport<T>::ReportExtraMemory, or by giving T a member function
+     
+     std::size_t SizeOf() const;
+     
+     which JSExport calls once a native object of class T is
+     initialized, and whose result is reported as that object's extra
+     memory. Either way the garbage collector is told about the memory,
+     so that it collects JavaScript objects holding large native
+     objects sooner, if HAL is built with HAL_PRIVATE_API_ENABLE.
+     */
+    static std::size_t get_extra_memory_size() HAL_NOEXCEPT {
+      return detail::JSExportTypeInfo<T>::memory_counter.extra_memory_size;
+    }
+    
+    /*!
+     @method
+     
+     @abstract Return the number of bytes of extra memory ever reported
+     for native objects of class T, including those since destroyed.
+     */
+    static std::size_t get_extra_memory_reported() HAL_NOEXCEPT {
+      return detail::JSExportTypeInfo<T>::memory_counter.extra_memory_reported;
+    }
+    
+    /*!
+     @method
+     
+     @abstract Return the JavaScript object whose private data the
+     given native object is.
+     
+     @discussion Use this to hand a native object that JavaScript has
+     already seen back to JavaScript, for example from a property
+     getter, so that it gets the same object, and === holds. The
+     native object points back at its JavaScript object, so no new
+     JavaScript object is created. The returned JSObject protects and
+     registers the JavaScript object under JSObject's static mutex,
+     like any JSObject.
+     
+     The native object must have been created by JSExport for a
+     JavaScript object of the given context's JSContextGroup, and that
+     JavaScript object must still be reachable, for example because
+     the native object was reached through it or through a JSObject
+     that is still alive. JavaScriptCore's public API can't tell a
+     JavaScript object that the garbage collector found unreachable
+     but hasn't finalized yet, and handing one back to script is
+     undefined behavior.
+     
+     @param js_context The context to return the JavaScript object in.
+     
+     @param native_object The native object.
+     
+     @throws std::runtime_error if the native object's JavaScript
+     object belongs to another JSContextGroup or is still being
+     initialized by a parent class.
+     */
+    static JSObject FindJSObject(const JSContext& js_context, T& native_object);
+    
+    /*!
+     @method
+     
+     @abstract Record that the native object of the given JavaScript
+     object holds memory outside the JavaScript heap, such as a decoded
+     bitmap, so that the garbage collector collects the JavaScript
+     object sooner.
+     
+     @discussion Call this each time the native object allocates a
+     large buffer, for example from one of its function properties with
+     the this_object it is called with. The bytes are added to
+     get_extra_memory_size() for the native object's class until the
+     native object is destroyed. The garbage collector has no way to
+     be told that memory was freed early, so there is nothing to call
+     when a buffer is released.
+     
+     Telling the garbage collector uses JSReportExtraMemoryCost, which
+     isn't part of JavaScriptCore's public API, so it only happens when
+     HAL is built with HAL_PRIVATE_API_ENABLE. Otherwise only the
+     totals are kept.
+     
+     @param js_object A JavaScript object of class T, or of a class
+     derived from it.
+     
+     @param bytes The number of bytes allocated.
+     
+     @throws std::runtime_error if js_object wasn't created by
+     JSExport<T> or a class derived from it.
+     */
+    static void ReportExtraMemory(const JSObject& js_object, std::size_t bytes);
+    
     virtual ~JSExport() HAL_NOEXCEPT {
     }
     
@@ -149,7 +246,7 @@ namespace HAL {
      object its own copy of your JSClass's JavaScript function
      objects.
      */
-    static void SetClassAttribute(JSClassAttribute class_attribute);
+    static void SetClassAttribute(JSClassAttributes class_attributes);
     
     /*!
      @method
@@ -505,14 +602,24 @@ namespace HAL {
     static detail::JSExportClassDefinitionBuilder<T> builder__;
   };
   
+  template<typename T>
+  JSObject JSExport<T>::FindJSObject(const JSContext& js_context, T& native_object) {
+    return detail::JSExportClass<T>::FindJSObject(js_context, dynamic_cast<void*>(&native_object));
+  }
+  
+  template<typename T>
+  void JSExport<T>::ReportExtraMemory(const JSObject& js_object, std::size_t bytes) {
+    detail::JSExportClass<T>::ReportExtraMemory(js_object, bytes);
+  }
+  
   template<typename T>
   void JSExport<T>::SetClassVersion(uint32_t class_version) {
     builder__.Version(class_version);
   }
   
   template<typename T>
-  void JSExport<T>::SetClassAttribute(JSClassAttribute class_attribute) {
-    builder__.ClassAttribute(class_attribute);
+  void JSExport<T>::SetClassAttribute(JSClassAttributes class_attributes) {
+    builder__.ClassAttribute(class_attributes);
   }
   
   template<typename T>
@@ -570,13 +677,11 @@ namespace HAL {
   
   template<typename T>
   detail::JSExportClass<T> JSExport<T>::Class() {
-    static detail::JSExportClassDefinition<T> js_export_class_definition;
-    static detail::JSExportClass<T>           js_export_class;
-    static std::once_flag                     of;
+    static detail::JSExportClass<T> js_export_class;
+    static std::once_flag           of;
     std::call_once(of, []() {
       T::JSExportInitialize();
-      js_export_class_definition = builder__.build();
-      js_export_class            = detail::JSExportClass<T>(js_export_class_definition);
+      js_export_class = detail::JSExportClass<T>(builder__.build());
     });
     
     return js_export_class;
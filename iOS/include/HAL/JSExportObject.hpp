@@ -97,13 +97,11 @@ namespace HAL {
     
     JSContext js_context__;
     
+    // A JSExportObject belongs to the thread of its context group's
+    // executor, so it doesn't lock. Debug builds check the calling
+    // thread.
 #undef  HAL_JSEXPORTOBJECT_LOCK_GUARD
-#ifdef  HAL_THREAD_SAFE
-    std::recursive_mutex mutex__;
-#define HAL_JSEXPORTOBJECT_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock(mutex__)
-#else
-#define HAL_JSEXPORTOBJECT_LOCK_GUARD
-#endif  // HAL_THREAD_SAFE
+#define HAL_JSEXPORTOBJECT_LOCK_GUARD HAL_DETAIL_JSTHREADCONFINEMENT_CHECK(static_cast<JSContextRef>(js_context__))
   };
   
   inline
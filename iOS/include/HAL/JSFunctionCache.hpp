@@ -0,0 +1,231 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSFUNCTIONCACHE_HPP_
+#define _HAL_JSFUNCTIONCACHE_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSString.hpp"
+#include "HAL/JSFunction.hpp"
+#include "HAL/detail/HashUtilities.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSFunctionCache remembers the functions compiled by
+   JSContext::CreateFunction so that compiling the same body again
+   returns the already compiled JSFunction instead of re-parsing it.
+   Create one JSFunctionCache per JSContextGroup and use it for all of
+   that group's contexts, on the group's executor thread if it has one.
+
+   A compiled function belongs to the context it was compiled in, so
+   entries are keyed by the context as well as by the body, parameter
+   names, function name, source URL and starting line number. Looking
+   up an entry doesn't allocate memory.
+
+   The cache is bounded by the size of the source it holds. When adding
+   a function would exceed the capacity, the least recently used
+   functions are evicted first. A cached JSFunction keeps its context
+   alive, so call Clear() before releasing the last reference to a
+   context whose functions are cached.
+   */
+  class JSFunctionCache final HAL_PERFORMANCE_COUNTER1(JSFunctionCache) {
+
+  public:
+
+    /*!
+     @method
+
+     @abstract Create an empty cache.
+
+     @param capacity_in_bytes The approximate amount of memory, as
+     measured by the size of the cached source, above which the least
+     recently used functions are evicted.
+     */
+    explicit JSFunctionCache(std::size_t capacity_in_bytes = 1024 * 1024) HAL_NOEXCEPT
+    : capacity_in_bytes__(capacity_in_bytes) {
+    }
+
+    /*!
+     @method
+
+     @abstract Return a JavaScript function whose body is given as a
+     string of JavaScript code, compiling it with
+     JSContext::CreateFunction only if it isn't already cached.
+
+     @discussion The parameters have the same meaning as for
+     JSContext::CreateFunction.
+
+     @throws std::invalid_argument if either body, function_name or
+     parameter_names contains a syntax error.
+     */
+    JSFunction CreateFunction(const JSContext& js_context, const JSString& body, const std::vector<JSString>& parameter_names = {}, const JSString& function_name = JSString(), const JSString& source_url = JSString(), int starting_line_number = 1) {
+      const auto js_context_ref = static_cast<JSContextRef>(js_context);
+
+      std::size_t hash_value = detail::JSStringUnits(body).Hash();
+      detail::hash_combine(hash_value, reinterpret_cast<std::uintptr_t>(js_context_ref));
+      for (const auto& parameter_name : parameter_names) {
+        detail::hash_combine(hash_value, detail::JSStringUnits(parameter_name).Hash());
+      }
+      detail::hash_combine(hash_value, detail::JSStringUnits(function_name).Hash());
+      detail::hash_combine(hash_value, detail::JSStringUnits(source_url).Hash());
+      detail::hash_combine(hash_value, starting_line_number);
+
+      const auto range = index__.equal_range(hash_value);
+      for (auto position = range.first; position != range.second; ++position) {
+        const auto entry = position -> second;
+        if (entry -> Matches(js_context_ref, body, parameter_names, function_name, source_url, starting_line_number)) {
+          ++hits__;
+          entries__.splice(entries__.begin(), entries__, entry);
+          return entry -> js_function;
+        }
+      }
+
+      ++misses__;
+      const JSFunction js_function = js_context.CreateFunction(body, parameter_names, function_name, source_url, starting_line_number);
+      entries__.emplace_front(hash_value, js_context_ref, body, parameter_names, function_name, source_url, starting_line_number, js_function);
+      index__.emplace(hash_value, entries__.begin());
+      size_in_bytes__ += entries__.front().size_in_bytes;
+      Evict();
+      return js_function;
+    }
+
+    /*!
+     @method
+
+     @abstract Remove every cached function.
+     */
+    void Clear() HAL_NOEXCEPT {
+      index__.clear();
+      entries__.clear();
+      size_in_bytes__ = 0;
+    }
+
+    // Return the number of calls to CreateFunction that returned a
+    // cached function.
+    std::size_t get_hits() const HAL_NOEXCEPT {
+      return hits__;
+    }
+
+    // Return the number of calls to CreateFunction that compiled a
+    // function.
+    std::size_t get_misses() const HAL_NOEXCEPT {
+      return misses__;
+    }
+
+    std::size_t size() const HAL_NOEXCEPT {
+      return entries__.size();
+    }
+
+    std::size_t get_size_in_bytes() const HAL_NOEXCEPT {
+      return size_in_bytes__;
+    }
+
+    std::size_t get_capacity_in_bytes() const HAL_NOEXCEPT {
+      return capacity_in_bytes__;
+    }
+
+    JSFunctionCache(const JSFunctionCache&)            = delete;
+    JSFunctionCache& operator=(const JSFunctionCache&) = delete;
+
+  private:
+
+    struct Entry final {
+
+      Entry(std::size_t hash_value, JSContextRef js_context_ref, const JSString& body, const std::vector<JSString>& parameter_names, const JSString& function_name, const JSString& source_url, int starting_line_number, const JSFunction& js_function)
+      : hash_value(hash_value)
+      , js_context_ref(js_context_ref)
+      , body(ToUTF16String(body))
+      , function_name(ToUTF16String(function_name))
+      , source_url(ToUTF16String(source_url))
+      , starting_line_number(starting_line_number)
+      , js_function(js_function) {
+        this -> parameter_names.reserve(parameter_names.size());
+        size_in_bytes = sizeof(Entry) + (this -> body.size() + this -> function_name.size() + this -> source_url.size()) * sizeof(char16_t);
+        for (const auto& parameter_name : parameter_names) {
+          this -> parameter_names.push_back(ToUTF16String(parameter_name));
+          size_in_bytes += sizeof(std::u16string) + this -> parameter_names.back().size() * sizeof(char16_t);
+        }
+      }
+
+      bool Matches(JSContextRef js_context_ref, const JSString& body, const std::vector<JSString>& parameter_names, const JSString& function_name, const JSString& source_url, int starting_line_number) const HAL_NOEXCEPT {
+        if (this -> js_context_ref != js_context_ref || this -> starting_line_number != starting_line_number || this -> parameter_names.size() != parameter_names.size()) {
+          return false;
+        }
+        if (!Equal(this -> body, body) || !Equal(this -> function_name, function_name) || !Equal(this -> source_url, source_url)) {
+          return false;
+        }
+        for (std::size_t i = 0; i < parameter_names.size(); ++i) {
+          if (!Equal(this -> parameter_names[i], parameter_names[i])) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      static std::u16string ToUTF16String(const JSString& js_string) {
+        const detail::JSStringUnits units(js_string);
+        return std::u16string(units.data(), units.size());
+      }
+
+      static bool Equal(const std::u16string& string, const JSString& js_string) HAL_NOEXCEPT {
+        return detail::JSStringUnits::Equal(detail::JSStringUnits(string), detail::JSStringUnits(js_string));
+      }
+
+      std::size_t                 hash_value;
+      JSContextRef                js_context_ref;
+      std::u16string              body;
+      std::vector<std::u16string> parameter_names;
+      std::u16string              function_name;
+      std::u16string              source_url;
+      int                         starting_line_number;
+      JSFunction                  js_function;
+      std::size_t                 size_in_bytes;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    // Evict the least recently used functions until the cache fits
+    // its capacity, always keeping the most recently used one.
+    void Evict() HAL_NOEXCEPT {
+      while (size_in_bytes__ > capacity_in_bytes__ && entries__.size() > 1) {
+        const auto entry = std::prev(entries__.end());
+        const auto range = index__.equal_range(entry -> hash_value);
+        for (auto position = range.first; position != range.second; ++position) {
+          if (position -> second == entry) {
+            index__.erase(position);
+            break;
+          }
+        }
+        size_in_bytes__ -= entry -> size_in_bytes;
+        entries__.erase(entry);
+      }
+    }
+
+    EntryList                                                        entries__;
+    std::unordered_multimap<std::size_t, typename EntryList::iterator> index__;
+    std::size_t                                                      capacity_in_bytes__;
+    std::size_t                                                      size_in_bytes__ { 0 };
+    std::size_t                                                      hits__          { 0 };
+    std::size_t                                                      misses__        { 0 };
+  };
+
+} // namespace HAL {
+
+#endif // _HAL_JSFUNCTIONCACHE_HPP_
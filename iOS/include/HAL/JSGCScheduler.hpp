@@ -0,0 +1,365 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSGCSCHEDULER_HPP_
+#define _HAL_JSGCSCHEDULER_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSExport.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSGCScheduler decides when to ask the garbage collector
+   to run, instead of calling JSContext::GarbageCollect at arbitrary
+   points. Create one per JSContextGroup, on the thread that runs the
+   group's scripts.
+
+   The scheduler watches counters of allocations and of extra memory
+   reported by native objects. Once either grows past its threshold
+   since the last collection, or someone calls RequestCollection, a
+   collection is pending. The host calls OnIdle with the deadline of
+   its next frame whenever it has time to spare, and the scheduler only
+   collects if a collection is pending and the time left before the
+   deadline is at least the pause estimate. A collection that has been
+   deferred for Options::max_deferral runs at the next OnIdle anyway,
+   so that a host that is never idle long enough doesn't starve it.
+
+   A collection collects the whole group, so requests from all of the
+   group's contexts coalesce into one collection. The scheduler
+   collects with JSContext::GarbageCollect, which is JavaScriptCore's
+   public JSGarbageCollect. JavaScriptCore may do some or all of the
+   work after it returns, so the pause recorded for each collection is
+   only the time the call blocked the calling thread, and the pause
+   estimate never drops below Options::pause_estimate. Collections are
+   recorded for analysis with get_collections or GetReport.
+
+   For example:
+
+   JSGCScheduler gc_scheduler(js_context);
+   gc_scheduler.WatchExtraMemory<Bitmap>();
+
+   // In the host's frame loop, after rendering:
+   gc_scheduler.OnIdle(next_frame_deadline);
+   */
+  class JSGCScheduler final HAL_PERFORMANCE_COUNTER1(JSGCScheduler) {
+
+  public:
+
+    using Clock   = std::chrono::steady_clock;
+    using Counter = std::function<std::size_t()>;
+
+    enum class Reason {
+      Requested,
+      ExtraMemory,
+      Allocations
+    };
+
+    struct Options final {
+
+      // The extra memory, in bytes, reported since the last collection
+      // above which a collection is pending.
+      std::size_t extra_memory_threshold { 8 * 1024 * 1024 };
+
+      // The number of allocations since the last collection above which
+      // a collection is pending.
+      std::size_t allocation_threshold { 50000 };
+
+      // The shortest time between two collections, unless one was
+      // requested.
+      Clock::duration min_interval { std::chrono::seconds(1) };
+
+      // The pause assumed for a collection. Recorded pauses only raise
+      // the estimate above it, since JSContext::GarbageCollect can
+      // return before JavaScriptCore has done the work.
+      Clock::duration pause_estimate { std::chrono::milliseconds(4) };
+
+      // The longest OnIdle defers a pending collection for lack of
+      // idle time before it collects anyway.
+      Clock::duration max_deferral { std::chrono::seconds(5) };
+
+      // The number of collections kept for analysis.
+      std::size_t history_size { 64 };
+    };
+
+    struct Collection final {
+      Clock::time_point start;
+      // The time JSContext::GarbageCollect blocked the calling thread,
+      // an estimate of the collection's pause.
+      Clock::duration   pause;
+      Reason            reason;
+      std::size_t       extra_memory;
+      std::size_t       allocations;
+      // True if the collection ran outside an idle window because it
+      // had been deferred for Options::max_deferral.
+      bool              overdue;
+    };
+
+    /*!
+     @method
+
+     @abstract Create a scheduler that collects through the given
+     context, which may be any context of the group.
+
+     @discussion When the JSPerformanceCounters are enabled, the
+     number of JSObjects created is watched as an allocation counter.
+     */
+    explicit JSGCScheduler(const JSContext& js_context)
+    : JSGCScheduler(js_context, Options()) {
+    }
+
+    JSGCScheduler(const JSContext& js_context, const Options& options)
+    : js_context__(js_context)
+    , options__(options)
+    , last_collection__(Clock::now()) {
+#ifdef HAL_PERFORMANCE_COUNTER_ENABLE
+      AddAllocationCounter([] { return static_cast<std::size_t>(detail::JSPerformanceCounter<JSObject>::get_objects_created()); });
+#endif
+    }
+
+    /*!
+     @method
+
+     @abstract Watch a counter that only grows, such as a number of
+     objects created.
+     */
+    void AddAllocationCounter(Counter counter) {
+      allocation_counters__.emplace_back(std::move(counter));
+      allocation_counters__.back().Reset();
+    }
+
+    /*!
+     @method
+
+     @abstract Watch a counter of bytes reported outside the JavaScript
+     heap that only grows.
+     */
+    void AddExtraMemoryCounter(Counter counter) {
+      extra_memory_counters__.emplace_back(std::move(counter));
+      extra_memory_counters__.back().Reset();
+    }
+
+    /*!
+     @method
+
+     @abstract Watch the extra memory reported for the native objects
+     of the JSExport class T.
+     */
+    template<typename T>
+    void WatchExtraMemory() {
+      AddExtraMemoryCounter([] { return JSExport<T>::get_extra_memory_reported(); });
+    }
+
+    /*!
+     @method
+
+     @abstract Ask for a collection at the next idle window. Any number
+     of requests made before it coalesce into one collection. Safe to
+     call from any thread.
+     */
+    void RequestCollection() HAL_NOEXCEPT {
+      requested__.store(true);
+    }
+
+    /*!
+     @method
+
+     @abstract Tell the scheduler the host is idle until the given
+     deadline, and collect if a collection is pending and either fits
+     or has been deferred for Options::max_deferral.
+
+     @result true if a collection ran.
+     */
+    bool OnIdle(Clock::time_point deadline) {
+      const auto now = Clock::now();
+      Reason     reason;
+      if (!IsPending(now, reason)) {
+        return false;
+      }
+      bool overdue = false;
+      if (deadline - now < GetPauseEstimate()) {
+        if (!deferring__) {
+          deferring__      = true;
+          deferred_since__ = now;
+        }
+        overdue = now - deferred_since__ >= options__.max_deferral;
+        if (!overdue) {
+          ++deferred__;
+          return false;
+        }
+      }
+      Collect(now, reason, overdue);
+      return true;
+    }
+
+    /*!
+     @method
+
+     @abstract Return the pause expected from the next collection: the
+     longest of the last few recorded pauses, or Options::pause_estimate
+     if that is longer.
+     */
+    Clock::duration GetPauseEstimate() const HAL_NOEXCEPT {
+      const std::size_t count = std::min<std::size_t>(collections__.size(), 8);
+      Clock::duration pause_estimate = options__.pause_estimate;
+      for (auto position = collections__.end() - count; position != collections__.end(); ++position) {
+        pause_estimate = std::max(pause_estimate, position -> pause);
+      }
+      return pause_estimate;
+    }
+
+    // Return the most recent collections, oldest first.
+    const std::deque<Collection>& get_collections() const HAL_NOEXCEPT {
+      return collections__;
+    }
+
+    // Return the number of times OnIdle found a collection pending but
+    // the idle window too short.
+    std::size_t get_deferred() const HAL_NOEXCEPT {
+      return deferred__;
+    }
+
+    /*!
+     @method
+
+     @abstract Return a human readable summary of the recorded
+     collections.
+     */
+    std::string GetReport() const {
+      using std::chrono::duration_cast;
+      using std::chrono::microseconds;
+      std::ostringstream os;
+      os << "JSGCScheduler: " << collections__.size() << " collections recorded, " << deferred__ << " deferred for lack of idle time";
+      std::size_t overdue = 0;
+      Clock::duration total_pause { 0 };
+      Clock::duration max_pause   { 0 };
+      for (const auto& collection : collections__) {
+        total_pause += collection.pause;
+        max_pause    = std::max(max_pause, collection.pause);
+        overdue     += collection.overdue ? 1 : 0;
+        os << "\n" << ToString(collection.reason) << (collection.overdue ? " (overdue)" : "") << ": pause " << duration_cast<microseconds>(collection.pause).count() << " us, "
+           << collection.extra_memory << " bytes of extra memory, " << collection.allocations << " allocations";
+      }
+      if (!collections__.empty()) {
+        os << "\nmean pause " << duration_cast<microseconds>(total_pause).count() / static_cast<long long>(collections__.size()) << " us, max pause " << duration_cast<microseconds>(max_pause).count() << " us, "
+           << overdue << " overdue";
+      }
+      return os.str();
+    }
+
+    static const char* ToString(Reason reason) HAL_NOEXCEPT {
+      switch (reason) {
+        case Reason::Requested:   return "Requested";
+        case Reason::ExtraMemory: return "ExtraMemory";
+        case Reason::Allocations: return "Allocations";
+      }
+      return "Unknown";
+    }
+
+    JSGCScheduler(const JSGCScheduler&)            = delete;
+    JSGCScheduler& operator=(const JSGCScheduler&) = delete;
+
+  private:
+
+    // A watched counter and its value at the last collection.
+    struct WatchedCounter final {
+
+      explicit WatchedCounter(Counter counter)
+      : counter(std::move(counter)) {
+      }
+
+      std::size_t GetDelta() const {
+        const std::size_t value = counter();
+        return value > baseline ? value - baseline : 0;
+      }
+
+      void Reset() {
+        baseline = counter();
+      }
+
+      Counter     counter;
+      std::size_t baseline { 0 };
+    };
+
+    static std::size_t Sum(const std::vector<WatchedCounter>& counters) {
+      std::size_t sum = 0;
+      for (const auto& counter : counters) {
+        sum += counter.GetDelta();
+      }
+      return sum;
+    }
+
+    bool IsPending(Clock::time_point now, Reason& reason) const {
+      if (requested__.load()) {
+        reason = Reason::Requested;
+        return true;
+      }
+      if (now - last_collection__ < options__.min_interval) {
+        return false;
+      }
+      if (Sum(extra_memory_counters__) >= options__.extra_memory_threshold) {
+        reason = Reason::ExtraMemory;
+        return true;
+      }
+      if (Sum(allocation_counters__) >= options__.allocation_threshold) {
+        reason = Reason::Allocations;
+        return true;
+      }
+      return false;
+    }
+
+    void Collect(Clock::time_point now, Reason reason, bool overdue) {
+      const std::size_t extra_memory = Sum(extra_memory_counters__);
+      const std::size_t allocations  = Sum(allocation_counters__);
+      requested__.store(false);
+      deferring__ = false;
+
+      js_context__.GarbageCollect();
+      last_collection__ = Clock::now();
+
+      collections__.push_back(Collection { now, last_collection__ - now, reason, extra_memory, allocations, overdue });
+      while (collections__.size() > options__.history_size) {
+        collections__.pop_front();
+      }
+      for (auto& counter : extra_memory_counters__) {
+        counter.Reset();
+      }
+      for (auto& counter : allocation_counters__) {
+        counter.Reset();
+      }
+      HAL_LOG_DEBUG("JSGCScheduler: ", ToString(reason), " collection paused ", std::chrono::duration_cast<std::chrono::microseconds>(last_collection__ - now).count(), " us");
+    }
+
+    JSContext                   js_context__;
+    Options                     options__;
+    std::vector<WatchedCounter> allocation_counters__;
+    std::vector<WatchedCounter> extra_memory_counters__;
+    std::deque<Collection>      collections__;
+    Clock::time_point           last_collection__;
+    Clock::time_point           deferred_since__;
+    bool                        deferring__ { false };
+    std::size_t                 deferred__  { 0 };
+    std::atomic<bool>           requested__ { false };
+  };
+
+} // namespace HAL {
+
+#endif // _HAL_JSGCSCHEDULER_HPP_
@@ -0,0 +1,261 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSLAZYCLASSINSTALLER_HPP_
+#define _HAL_JSLAZYCLASSINSTALLER_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSContextView.hpp"
+#include "HAL/JSString.hpp"
+#include "HAL/JSValue.hpp"
+#include "HAL/JSBoolean.hpp"
+#include "HAL/JSObject.hpp"
+#include "HAL/JSExport.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSLazyClassInstaller installs constructors on a
+   context's global object without creating them. Each installed name
+   is a placeholder accessor property. The first time script reads the
+   name, the placeholder runs the factory, replaces itself with the
+   result as an ordinary property and returns it. For a JSExport class
+   the factory is what makes JSExport<T>::Class() run
+   T::JSExportInitialize() and build the class, so a class that script
+   never touches is never built.
+
+   For example, instead of eagerly installing every module:
+
+   global_object.SetProperty("Widget", js_context.CreateObject(JSExport<Widget>::Class()));
+
+   you would write:
+
+   JSLazyClassInstaller installer(js_context);
+   installer.Install<Widget>("Widget");
+
+   Assigning to an installed name before reading it replaces the
+   placeholder with the assigned value without running the factory.
+
+   GetReport() lists which names were materialized, in the order script
+   needed them, and which were never touched. Call it once startup is
+   complete to see which classes startup actually needed.
+
+   The installer can be destroyed before the context; the
+   placeholders keep working.
+   */
+  class JSLazyClassInstaller final HAL_PERFORMANCE_COUNTER1(JSLazyClassInstaller) {
+
+  public:
+
+    using Factory = std::function<JSValue(const JSContext& js_context)>;
+
+    /*!
+     @method
+
+     @abstract Create an installer for the given context's global
+     object.
+     */
+    explicit JSLazyClassInstaller(const JSContext& js_context)
+    : js_context__(js_context)
+    , state__(std::make_shared<State>()) {
+    }
+
+    /*!
+     @method
+
+     @abstract Install a placeholder for the JSExport class T. When
+     script first reads the name, the placeholder is replaced by a
+     JavaScript object of class JSExport<T>::Class(), which script can
+     use as T's constructor.
+
+     @param name The name of the global object's property.
+     */
+    template<typename T>
+    void Install(const std::string& name) {
+      Install(name, [](const JSContext& js_context) -> JSValue {
+        return js_context.CreateObject(JSExport<T>::Class());
+      });
+    }
+
+    /*!
+     @method
+
+     @abstract Install a placeholder whose value is created by the
+     given factory when script first reads the name.
+
+     @param name The name of the global object's property.
+
+     @param factory The function that creates the property's value.
+     */
+    void Install(const std::string& name, Factory factory) {
+      state__ -> Add(name, std::move(factory));
+
+      const auto          state = state__;
+      const JSContextView js_context_view(js_context__);
+
+      // The placeholder functions only borrow the context. They belong
+      // to its global object, so they are never called after it is
+      // gone.
+      const auto getter = js_context__.CreateFunction([state, js_context_view, name]() -> JSValue {
+        const auto js_context = js_context_view.Promote();
+        Factory factory;
+        if (!state -> Find(name, factory)) {
+          // Someone kept the placeholder after it was replaced.
+          return js_context.get_global_object().GetProperty(name);
+        }
+        HAL_LOG_DEBUG("JSLazyClassInstaller: materialize ", name);
+        // The factory is only removed once the placeholder is replaced,
+        // so if the factory throws the next read tries again.
+        const auto js_value = factory(js_context);
+        Replace(js_context, name, js_value);
+        state -> Remove(name);
+        return js_value;
+      });
+
+      const auto setter = js_context__.CreateFunction([state, js_context_view, name](const JSValue& js_value) {
+        Replace(js_context_view.Promote(), name, js_value);
+        state -> Remove(name, false);
+      });
+
+      auto descriptor = js_context__.CreateObject();
+      descriptor.SetProperties({
+        { "get"         , getter                              },
+        { "set"         , setter                              },
+        { "configurable", js_context__.CreateBoolean(true)    }
+      });
+
+      const auto global_object   = js_context__.get_global_object();
+      const auto object          = static_cast<JSObject>(global_object.GetProperty("Object"));
+      const auto define_property = static_cast<JSObject>(object.GetProperty("defineProperty"));
+      define_property.Call(object, global_object, name, descriptor);
+    }
+
+    /*!
+     @method
+
+     @abstract Return the installed names that script has read, in the
+     order it first read them.
+     */
+    std::vector<std::string> get_materialized_names() const {
+      return state__ -> GetMaterializedNames();
+    }
+
+    /*!
+     @method
+
+     @abstract Return the installed names that script has neither read
+     nor assigned, in the order they were installed.
+     */
+    std::vector<std::string> get_pending_names() const {
+      return state__ -> GetPendingNames();
+    }
+
+    /*!
+     @method
+
+     @abstract Return a human readable report of the names that were
+     materialized and the names that were never touched.
+     */
+    std::string GetReport() const {
+      const auto materialized_names = get_materialized_names();
+      const auto pending_names      = get_pending_names();
+
+      std::ostringstream os;
+      os << "JSLazyClassInstaller: " << materialized_names.size() << " of " << state__ -> GetInstalledCount() << " installed names materialized";
+      const auto print = [&os](const char* heading, const std::vector<std::string>& names) {
+        os << "\n" << heading << ":";
+        for (const auto& name : names) {
+          os << " " << name;
+        }
+      };
+      print("materialized", materialized_names);
+      print("never touched", pending_names);
+      return os.str();
+    }
+
+  private:
+
+    // The state is shared with the placeholder functions, which may
+    // outlive the installer.
+    struct State final {
+
+      // Installing a name again replaces its factory.
+      void Add(const std::string& name, Factory factory) {
+        factories[name] = std::move(factory);
+        if (std::find(installed_names.begin(), installed_names.end(), name) == installed_names.end()) {
+          installed_names.push_back(name);
+        }
+      }
+
+      // Copy the name's factory. Return false if the placeholder was
+      // already replaced.
+      bool Find(const std::string& name, Factory& factory) const {
+        const auto position = factories.find(name);
+        if (position == factories.end()) {
+          return false;
+        }
+        factory = position -> second;
+        return true;
+      }
+
+      // Remove the name's factory once its placeholder is replaced,
+      // recording the name as materialized if requested.
+      void Remove(const std::string& name, bool materialize = true) {
+        if (factories.erase(name) > 0 && materialize && std::find(materialized_names.begin(), materialized_names.end(), name) == materialized_names.end()) {
+          materialized_names.push_back(name);
+        }
+      }
+
+      std::vector<std::string> GetMaterializedNames() {
+        return materialized_names;
+      }
+
+      std::vector<std::string> GetPendingNames() {
+        std::vector<std::string> pending_names;
+        for (const auto& name : installed_names) {
+          if (factories.count(name) > 0) {
+            pending_names.push_back(name);
+          }
+        }
+        return pending_names;
+      }
+
+      std::size_t GetInstalledCount() {
+        return installed_names.size();
+      }
+
+      std::unordered_map<std::string, Factory> factories;
+      std::vector<std::string>                 installed_names;
+      std::vector<std::string>                 materialized_names;
+    };
+
+    // Replace the placeholder with an ordinary property.
+    static void Replace(const JSContext& js_context, const std::string& name, const JSValue& js_value) {
+      auto global_object = js_context.get_global_object();
+      global_object.DeleteProperty(name);
+      global_object.SetProperty(name, js_value);
+    }
+
+    JSContext              js_context__;
+    std::shared_ptr<State> state__;
+  };
+
+} // namespace HAL {
+
+#endif // _HAL_JSLAZYCLASSINSTALLER_HPP_
@@ -0,0 +1,293 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSLEAKDETECTOR_HPP_
+#define _HAL_JSLEAKDETECTOR_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSObject.hpp"
+#include "HAL/detail/JSLeakRegistry.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#if defined(HAL_LEAK_DETECTOR_ENABLE) && defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion The JSLeakDetector reports the JSExport native objects
+   that are still alive, grouped by class and by the backtrace of
+   their creation, together with the state of JSObject's registries of
+   private data and of contexts.
+
+   Build with -DHAL_LEAK_DETECTOR_ENABLE=1 to record a class name and
+   a backtrace for every native object a JSExport class creates.
+   Without it the report only has the registry sizes.
+
+   Private data registry entries without a live native object are
+   stale: their native object was destroyed without being
+   unregistered. The report traces them to where the native object was
+   created when it was destroyed recently enough.
+
+   Call GetReport or CollectAndReport from the executor thread when
+   tearing a context down, once its scripts have released everything
+   they should have:
+
+   const auto survivors = JSLeakDetector::CollectAndReport(js_context);
+   assert(survivors == 0);
+
+   JSObject's registries are mutated by the HAL library without the
+   mutex this class locks to copy them, so no other thread may create
+   or finalize JavaScript objects while a report is made.
+   */
+  class JSLeakDetector final {
+
+  public:
+
+    // Return true if HAL was built to record native objects.
+    static bool IsEnabled() HAL_NOEXCEPT {
+#ifdef HAL_LEAK_DETECTOR_ENABLE
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    /*!
+     @method
+
+     @abstract Return a compact report of all live native objects and
+     registry entries.
+     */
+    static std::string GetReport() {
+      return GetReport(nullptr, nullptr);
+    }
+
+    /*!
+     @method
+
+     @abstract Return a compact report of the live native objects and
+     registry entries of the given context's group.
+     */
+    static std::string GetReport(const JSContext& js_context) {
+      const auto js_context_ref = static_cast<JSContextRef>(js_context);
+      return GetReport(JSContextGetGroup(js_context_ref), js_context_ref);
+    }
+
+    /*!
+     @method
+
+     @abstract Run a full garbage collection and wait for it to
+     finish, then log a report of the native objects of the given
+     context's group that survived it.
+
+     @discussion The collection is conservative about the machine
+     stack, so a native object whose JavaScript object is still
+     referenced from a caller's frame survives it too.
+
+     Waiting for the collection uses
+     JSSynchronousGarbageCollectForDebugging, which isn't part of
+     JavaScriptCore's public API, so unless HAL was built with
+     HAL_LEAK_DETECTOR_ENABLE this neither collects nor reports.
+
+     @result The number of surviving native objects, always 0 unless
+     HAL was built with HAL_LEAK_DETECTOR_ENABLE.
+     */
+    static std::size_t CollectAndReport(const JSContext& js_context) {
+#ifdef HAL_LEAK_DETECTOR_ENABLE
+      JSSynchronousGarbageCollectForDebugging(static_cast<JSContextRef>(js_context));
+      const std::size_t survivors = get_live_count(js_context);
+      if (survivors > 0) {
+        HAL_LOG_WARN(GetReport(js_context));
+      }
+      return survivors;
+#else
+      static_cast<void>(js_context);
+      return 0;
+#endif
+    }
+
+    // Return the number of live native objects in the given context's
+    // group.
+    static std::size_t get_live_count(const JSContext& js_context) {
+      std::size_t count = 0;
+#ifdef HAL_LEAK_DETECTOR_ENABLE
+      const auto js_context_group_ref = JSContextGetGroup(static_cast<JSContextRef>(js_context));
+      for (const auto& entry : detail::JSLeakRegistry::GetLive()) {
+        count += entry.second.js_context_group_ref == js_context_group_ref ? 1 : 0;
+      }
+#else
+      static_cast<void>(js_context);
+#endif
+      return count;
+    }
+
+  private:
+
+    using PrivateDataEntries_t = std::vector<std::pair<std::intptr_t, std::intptr_t>>;
+    using ContextEntries_t     = std::map<std::intptr_t, std::size_t>;
+
+    // Copy the registries under JSObject's static mutex, without
+    // anything that could call back into JSObject. The mutex only
+    // excludes the header's own users of the registries: the HAL
+    // library mutates them without it, which is why reports must not
+    // race with other threads.
+    static void GetRegistries(PrivateDataEntries_t& private_data_entries, ContextEntries_t& context_entries) {
+      std::lock_guard<std::recursive_mutex> lock_static(JSObject::GetStaticMutex());
+      private_data_entries.assign(JSObject::js_private_data_to_js_object_ref_map__.begin(), JSObject::js_private_data_to_js_object_ref_map__.end());
+      for (const auto& entry : JSObject::js_object_ref_to_js_context_ref_map__) {
+        ++context_entries[std::get<0>(entry.second)];
+      }
+    }
+
+    // A null group means all groups.
+    static std::string GetReport(JSContextGroupRef js_context_group_ref, JSContextRef js_context_ref) {
+      PrivateDataEntries_t private_data_entries;
+      ContextEntries_t     context_entries;
+      GetRegistries(private_data_entries, context_entries);
+
+      std::ostringstream os;
+#ifdef HAL_LEAK_DETECTOR_ENABLE
+      // Live native objects, grouped by where they were created.
+      Sites_t     live_sites;
+      std::size_t live_count = 0;
+      for (const auto& entry : detail::JSLeakRegistry::GetLive()) {
+        if (js_context_group_ref == nullptr || entry.second.js_context_group_ref == js_context_group_ref) {
+          AddToSites(live_sites, entry.second);
+          ++live_count;
+        }
+      }
+      os << "JSLeakDetector: " << live_count << " JSExport objects alive from " << live_sites.size() << " allocation sites";
+      PrintSites(os, live_sites);
+
+      // Private data entries whose native object is gone.
+      Sites_t     stale_sites;
+      std::size_t stale_count   = 0;
+      std::size_t unknown_count = 0;
+      for (const auto& entry : private_data_entries) {
+        const auto private_data = reinterpret_cast<const void*>(entry.first);
+        if (detail::JSLeakRegistry::IsLive(private_data)) {
+          continue;
+        }
+        detail::JSLeakRecord record;
+        if (detail::JSLeakRegistry::FindDestroyed(private_data, record)) {
+          if (js_context_group_ref == nullptr || record.js_context_group_ref == js_context_group_ref) {
+            AddToSites(stale_sites, record);
+            ++stale_count;
+          }
+        } else if (js_context_group_ref == nullptr) {
+          ++unknown_count;
+        }
+      }
+      os << "\nJSLeakDetector: " << private_data_entries.size() << " private data registry entries, " << stale_count << " with a destroyed native object";
+      if (unknown_count > 0) {
+        os << ", " << unknown_count << " not created by JSExport or destroyed too long ago";
+      }
+      PrintSites(os, stale_sites);
+#else
+      static_cast<void>(js_context_group_ref);
+      os << "JSLeakDetector: build with HAL_LEAK_DETECTOR_ENABLE to record JSExport objects";
+      os << "\nJSLeakDetector: " << private_data_entries.size() << " private data registry entries";
+#endif
+
+      // Context registry entries, by context.
+      if (js_context_ref == nullptr) {
+        std::size_t context_entry_count = 0;
+        for (const auto& entry : context_entries) {
+          context_entry_count += entry.second;
+        }
+        os << "\nJSLeakDetector: " << context_entry_count << " context registry entries for " << context_entries.size() << " contexts";
+        for (const auto& entry : context_entries) {
+          os << "\n  JSContextRef " << reinterpret_cast<const void*>(entry.first) << ": " << entry.second << " entries";
+        }
+      } else {
+        const auto position = context_entries.find(reinterpret_cast<std::intptr_t>(js_context_ref));
+        os << "\nJSLeakDetector: " << (position == context_entries.end() ? 0 : position -> second) << " context registry entries for JSContextRef " << js_context_ref;
+      }
+
+      return os.str();
+    }
+
+#ifdef HAL_LEAK_DETECTOR_ENABLE
+    // Native objects of the same class created at the same place: the
+    // first one's record, and how many there are.
+    using SiteKey_t = std::tuple<const char*, std::vector<void*>>;
+    using Sites_t   = std::map<SiteKey_t, std::pair<detail::JSLeakRecord, std::size_t>>;
+
+    static void AddToSites(Sites_t& sites, const detail::JSLeakRecord& record) {
+      const SiteKey_t key(record.class_name, std::vector<void*>(record.frames.begin(), record.frames.begin() + record.frame_count));
+      auto& site = sites[key];
+      if (site.second++ == 0) {
+        site.first = record;
+      }
+    }
+
+    // Print the sites with the most native objects first.
+    static void PrintSites(std::ostream& os, const Sites_t& sites) {
+      std::vector<const Sites_t::mapped_type*> sorted;
+      for (const auto& site : sites) {
+        sorted.push_back(&site.second);
+      }
+      std::stable_sort(sorted.begin(), sorted.end(), [](const Sites_t::mapped_type* lhs, const Sites_t::mapped_type* rhs) {
+        return lhs -> second > rhs -> second;
+      });
+      for (const auto site : sorted) {
+        os << "\n" << site -> second << " x " << Demangle(site -> first.class_name);
+        PrintBacktrace(os, site -> first);
+      }
+    }
+
+    // Skip the frames of JSLeakRegistry::Track and JSExportClass's
+    // initialize callback.
+    static void PrintBacktrace(std::ostream& os, const detail::JSLeakRecord& record) {
+      const int first_frame = record.frame_count > 2 ? 2 : 0;
+#ifdef HAL_DETAIL_JSLEAKREGISTRY_BACKTRACE_ENABLE
+      char** symbols = ::backtrace_symbols(record.frames.data() + first_frame, record.frame_count - first_frame);
+      for (int i = 0; symbols && i < record.frame_count - first_frame; ++i) {
+        os << "\n  " << symbols[i];
+      }
+      std::free(symbols);
+#else
+      for (int i = first_frame; i < record.frame_count; ++i) {
+        os << "\n  " << record.frames[i];
+      }
+#endif
+    }
+
+    static std::string Demangle(const char* class_name) {
+      std::string result = class_name ? class_name : "unknown";
+#ifdef __GNUC__
+      int   status    = 0;
+      char* demangled = abi::__cxa_demangle(result.c_str(), nullptr, nullptr, &status);
+      if (status == 0 && demangled) {
+        result = demangled;
+      }
+      std::free(demangled);
+#endif
+      return result;
+    }
+#endif // HAL_LEAK_DETECTOR_ENABLE
+  };
+
+} // namespace HAL {
+
+#endif // _HAL_JSLEAKDETECTOR_HPP_
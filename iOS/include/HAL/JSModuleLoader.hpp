@@ -0,0 +1,661 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSMODULELOADER_HPP_
+#define _HAL_JSMODULELOADER_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSString.hpp"
+#include "HAL/JSValue.hpp"
+#include "HAL/JSObject.hpp"
+#include "HAL/JSBoolean.hpp"
+#include "HAL/JSScriptBundle.hpp"
+#include "HAL/detail/JSStringRefHolder.hpp"
+#include "HAL/detail/JSStringTranscoder.hpp"
+#include "HAL/detail/JSUtil.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSModuleLoader implements CommonJS require for a
+   JSContext, resolving module ids the way Node does: "./x" and "../x"
+   relative to the requiring module, "/x" from the root, and anything
+   else in the node_modules directories from the requiring module's
+   directory up, trying x, x.js, x/package.json's "main" and
+   x/index.js in that order. Modules ending in .json are parsed as
+   JSON.
+
+   Modules are read from a Source, either a JSScriptBundle or a
+   directory. Every resolution and every probe of the Source is
+   remembered, so requiring the same module from many places costs one
+   hash lookup, and each module is wrapped in a function once and run
+   once, after which require returns its memoized module.exports. Like
+   Node, a module required again while it is still loading, through a
+   cycle, gets its module.exports as it is so far.
+
+   Preload walks the graph of static require("...") calls from an
+   entry point on a pool of worker threads, reading, resolving and
+   scanning every module it finds in parallel, so that the require
+   calls that follow don't wait on I/O. Compiling has to happen on the
+   context's thread, since JavaScriptCore can't share compiled code
+   between context groups.
+
+   For example:
+
+   JSScriptBundle bundle("App.jsbundle");
+   JSModuleLoader loader(js_context, JSModuleLoader::FromBundle(bundle));
+   loader.Install();
+   loader.Preload("/app.js");
+   loader.Require("/app.js");
+
+   A JSModuleLoader belongs to its context's thread, except for
+   Preload's workers. The require functions it creates keep working
+   only as long as it exists.
+   */
+  class JSModuleLoader final HAL_PERFORMANCE_COUNTER1(JSModuleLoader) {
+
+  public:
+
+    /*!
+     @class
+
+     @discussion Where modules come from. Paths are absolute, '/'
+     separated and normalized, such as "/node_modules/lodash/index.js".
+     Both functions are called from Preload's worker threads as well.
+
+     @field exists Return whether a module file exists at the given
+     path. Directories don't count.
+
+     @field read Return a new JSStringRef, which the caller must
+     release, containing the file at the given path, or throw. The
+     loader hands it to JavaScriptCore as is, without the UTF-8 and
+     UTF-16 copies a JSString would make.
+     */
+    struct Source final {
+      std::function<bool(const std::string& path)>        exists;
+      std::function<JSStringRef(const std::string& path)> read;
+    };
+
+    // Return a Source for the scripts of the given bundle, which must
+    // outlive the loader's context. Scripts are read as views into the
+    // mapped bundle if HAL_PRIVATE_API_ENABLE allows it.
+    static Source FromBundle(const JSScriptBundle& bundle) {
+      const JSScriptBundle* bundle_ptr = &bundle;
+      return Source {
+        [bundle_ptr](const std::string& path) { return bundle_ptr -> Contains(path); },
+        [bundle_ptr](const std::string& path) { return bundle_ptr -> CreateScriptRef(path); }
+      };
+    }
+
+    // Return a Source for the UTF-8 files under the given directory.
+    static Source FromDirectory(const std::string& root) {
+      return Source {
+        [root](const std::string& path) {
+#ifdef _WIN32
+          // Directories can't be opened as files.
+          return static_cast<bool>(std::ifstream(root + path, std::ios::binary));
+#else
+          struct stat status;
+          return ::stat((root + path).c_str(), &status) == 0 && S_ISREG(status.st_mode);
+#endif
+        },
+        [root](const std::string& path) {
+          std::ifstream file(root + path, std::ios::binary);
+          if (!file) {
+            detail::ThrowRuntimeError("JSModuleLoader", "can't read " + root + path);
+          }
+          std::ostringstream os;
+          os << file.rdbuf();
+          const std::string    source    = os.str();
+          const std::u16string u16source = detail::ToUTF16String(source.data(), source.size());
+          return JSStringCreateWithCharacters(reinterpret_cast<const JSChar*>(u16source.data()), u16source.size());
+        }
+      };
+    }
+
+    JSModuleLoader(const JSContext& js_context, Source source)
+    : state__(std::make_shared<State>(js_context, std::move(source))) {
+    }
+
+    /*!
+     @method
+
+     @abstract Require a module from the root directory, as a script
+     at the root would.
+
+     @throws std::runtime_error if the module can't be found, or
+     running it threw an exception.
+     */
+    JSValue Require(const std::string& id) {
+      return state__ -> Require(state__, id, "/");
+    }
+
+    /*!
+     @method
+
+     @abstract Define a global require function that requires modules
+     from the root directory.
+     */
+    void Install() {
+      state__ -> js_context.get_global_object().SetProperty("require", state__ -> GetRequireFunction(state__, "/"));
+    }
+
+    /*!
+     @method
+
+     @abstract Return the path the given module id resolves to when
+     required from a module in the given directory.
+
+     @throws std::runtime_error if the module can't be found.
+     */
+    std::string Resolve(const std::string& id, const std::string& directory = "/") {
+      std::string path;
+      if (!state__ -> Resolve(id, directory, path)) {
+        ThrowModuleNotFound(id, directory);
+      }
+      return path;
+    }
+
+    /*!
+     @method
+
+     @abstract Read, resolve and scan the given module and everything
+     it statically requires on a pool of worker threads, and return
+     when they are ready to be required.
+
+     @discussion Only require calls with a string literal argument are
+     followed. Modules that can't be found or read are skipped here, so
+     that requiring them reports the error as usual.
+
+     @param worker_count The number of worker threads, by default one
+     per hardware thread.
+
+     @throws std::runtime_error if the module can't be found.
+     */
+    void Preload(const std::string& id, std::size_t worker_count = 0) {
+      const std::string entry = Resolve(id);
+      if (worker_count == 0) {
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+      }
+
+      std::mutex                      mutex;
+      std::condition_variable         condition_variable;
+      std::deque<std::string>         queue { entry };
+      std::unordered_set<std::string> seen  { entry };
+      std::size_t                     busy  { 0 };
+
+      const auto state  = state__;
+      auto       worker = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+          condition_variable.wait(lock, [&] { return !queue.empty() || busy == 0; });
+          if (queue.empty()) {
+            return;
+          }
+          const std::string path = std::move(queue.front());
+          queue.pop_front();
+          ++busy;
+          lock.unlock();
+
+          std::vector<std::string> dependencies;
+          state -> Prefetch(path, dependencies);
+
+          lock.lock();
+          for (auto& dependency : dependencies) {
+            if (seen.insert(dependency).second) {
+              queue.push_back(std::move(dependency));
+            }
+          }
+          --busy;
+          condition_variable.notify_all();
+        }
+      };
+
+      std::vector<std::thread> workers;
+      for (std::size_t i = 1; i < worker_count; ++i) {
+        workers.emplace_back(worker);
+      }
+      worker();
+      for (auto& thread : workers) {
+        thread.join();
+      }
+      HAL_LOG_DEBUG("JSModuleLoader: preloaded ", seen.size(), " modules from ", entry, " on ", worker_count, " threads");
+    }
+
+    /*!
+     @method
+
+     @abstract Forget every module's exports, so that requiring a
+     module runs it again, without compiling it again.
+     */
+    void ClearExports() {
+      state__ -> exports.clear();
+    }
+
+    // Return the number of resolutions answered from the cache.
+    std::size_t get_resolution_hits() const {
+      std::lock_guard<std::mutex> lock(state__ -> mutex);
+      return state__ -> resolution_hits;
+    }
+
+    // Return the number of times the Source was asked whether a file
+    // exists.
+    std::size_t get_probes() const {
+      std::lock_guard<std::mutex> lock(state__ -> mutex);
+      return state__ -> probes.size();
+    }
+
+    JSModuleLoader(const JSModuleLoader&)            = delete;
+    JSModuleLoader& operator=(const JSModuleLoader&) = delete;
+
+  private:
+
+    static void ThrowModuleNotFound(const std::string& id, const std::string& directory) {
+      detail::ThrowRuntimeError("JSModuleLoader", "Cannot find module '" + id + "' from '" + directory + "'");
+    }
+
+    static bool EndsWith(const std::string& string, const std::string& suffix) HAL_NOEXCEPT {
+      return string.size() >= suffix.size() && string.compare(string.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // Return the path with "." and ".." segments and repeated
+    // separators removed, always starting with '/'.
+    static std::string Normalize(const std::string& path) {
+      std::vector<std::string> segments;
+      std::size_t              begin = 0;
+      while (begin <= path.size()) {
+        std::size_t end = path.find('/', begin);
+        if (end == std::string::npos) {
+          end = path.size();
+        }
+        const std::string segment = path.substr(begin, end - begin);
+        if (segment == "..") {
+          if (!segments.empty()) {
+            segments.pop_back();
+          }
+        } else if (!segment.empty() && segment != ".") {
+          segments.push_back(segment);
+        }
+        begin = end + 1;
+      }
+      std::string result;
+      for (const auto& segment : segments) {
+        result += "/" + segment;
+      }
+      return result.empty() ? "/" : result;
+    }
+
+    // Return the directory of a normalized path, or an empty string
+    // for the root.
+    static std::string GetDirectory(const std::string& path) {
+      if (path == "/") {
+        return "";
+      }
+      const std::size_t separator = path.rfind('/');
+      return separator == 0 ? "/" : path.substr(0, separator);
+    }
+
+    static std::string Join(const std::string& directory, const std::string& path) {
+      return Normalize(directory + "/" + path);
+    }
+
+    // Return the module ids passed as string literals to require in the
+    // given source. Comments aren't skipped, so this may find more
+    // than there are, which only costs Preload some probes.
+    static std::vector<std::string> ScanRequires(JSStringRef source) {
+      static const char16_t kRequire[] = u"require";
+      const std::size_t     kLength    = sizeof(kRequire) / sizeof(kRequire[0]) - 1;
+
+      const detail::JSStringUnits units(source);
+      const char16_t*             begin = units.data();
+      const char16_t*             end   = begin + units.size();
+
+      const auto is_identifier = [](char16_t c) {
+        return (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z') || (c >= u'0' && c <= u'9') || c == u'_' || c == u'$' || c == u'.';
+      };
+      const auto skip_space = [end](const char16_t* p) {
+        while (p != end && (*p == u' ' || *p == u'\t' || *p == u'\n' || *p == u'\r')) {
+          ++p;
+        }
+        return p;
+      };
+
+      std::vector<std::string> ids;
+      for (const char16_t* p = begin; (p = std::search(p, end, kRequire, kRequire + kLength)) != end; p += kLength) {
+        if (p != begin && is_identifier(p[-1])) {
+          continue;
+        }
+        const char16_t* q = skip_space(p + kLength);
+        if (q == end || *q != u'(') {
+          continue;
+        }
+        q = skip_space(q + 1);
+        if (q == end || (*q != u'\'' && *q != u'"')) {
+          continue;
+        }
+        const char16_t  quote = *q++;
+        const char16_t* close = std::find(q, end, quote);
+        if (close == end || std::find(q, close, u'\\') != close || std::find(q, close, u'\n') != close) {
+          continue;
+        }
+        ids.push_back(detail::ToUTF8String(q, static_cast<std::size_t>(close - q)));
+      }
+      return ids;
+    }
+
+    // Everything the loader remembers. The require functions refer to
+    // it weakly, so that they fail instead of crashing once the loader
+    // is gone.
+    struct State final {
+
+      State(const JSContext& js_context, Source source)
+      : js_context(js_context)
+      , source(std::move(source)) {
+      }
+
+      // Return whether a module file exists, asking the Source only
+      // once per path.
+      bool Exists(const std::string& path) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          const auto position = probes.find(path);
+          if (position != probes.end()) {
+            return position -> second;
+          }
+        }
+        const bool exists = source.exists(path);
+        std::lock_guard<std::mutex> lock(mutex);
+        probes.emplace(path, exists);
+        return exists;
+      }
+
+      // Return the "main" of a package.json, or an empty string.
+      std::string GetPackageMain(const std::string& package_json_path) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          const auto position = package_mains.find(package_json_path);
+          if (position != package_mains.end()) {
+            return position -> second;
+          }
+        }
+        std::string main;
+        try {
+          const detail::JSStringRefHolder js_source(source.read(package_json_path));
+          const detail::JSStringUnits     units(js_source.js_string_ref__);
+          const std::string               package_json = detail::ToUTF8String(units.data(), units.size());
+          std::smatch       match;
+          if (std::regex_search(package_json, match, std::regex("\"main\"\\s*:\\s*\"([^\"\\\\]*)\""))) {
+            main = match[1];
+          }
+        } catch (const std::exception& e) {
+          HAL_LOG_WARN("JSModuleLoader: can't read ", package_json_path, ": ", e.what());
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        package_mains.emplace(package_json_path, main);
+        return main;
+      }
+
+      bool LoadAsFile(const std::string& path, std::string& result) {
+        for (const auto& candidate : { path, path + ".js", path + ".json" }) {
+          if (Exists(candidate)) {
+            result = candidate;
+            return true;
+          }
+        }
+        return false;
+      }
+
+      bool LoadAsDirectory(const std::string& path, std::string& result) {
+        const std::string package_json_path = Join(path, "package.json");
+        if (Exists(package_json_path)) {
+          const std::string main = GetPackageMain(package_json_path);
+          if (!main.empty()) {
+            const std::string main_path = Join(path, main);
+            if (LoadAsFile(main_path, result) || LoadAsFile(Join(main_path, "index"), result)) {
+              return true;
+            }
+          }
+        }
+        return LoadAsFile(Join(path, "index"), result);
+      }
+
+      bool Load(const std::string& path, std::string& result) {
+        return LoadAsFile(path, result) || LoadAsDirectory(path, result);
+      }
+
+      bool ResolveUncached(const std::string& id, const std::string& directory, std::string& result) {
+        if (id.empty()) {
+          return false;
+        }
+        if (id[0] == '/') {
+          return Load(Normalize(id), result);
+        }
+        if (id == "." || id == ".." || id.compare(0, 2, "./") == 0 || id.compare(0, 3, "../") == 0) {
+          return Load(Join(directory, id), result);
+        }
+        for (std::string search_directory = directory; !search_directory.empty(); search_directory = GetDirectory(search_directory)) {
+          if (EndsWith(search_directory, "/node_modules")) {
+            continue;
+          }
+          if (Load(Join(search_directory, "node_modules/" + id), result)) {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      // Resolve the given id from the given directory, remembering the
+      // result, found or not.
+      bool Resolve(const std::string& id, const std::string& directory, std::string& result) {
+        std::string key = directory;
+        key.push_back('\0');
+        key += id;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          const auto position = resolutions.find(key);
+          if (position != resolutions.end()) {
+            ++resolution_hits;
+            result = position -> second;
+            return !result.empty();
+          }
+        }
+        if (!ResolveUncached(id, directory, result)) {
+          result.clear();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        resolutions.emplace(std::move(key), result);
+        return !result.empty();
+      }
+
+      // Read a module and resolve what it requires, on a Preload
+      // worker.
+      void Prefetch(const std::string& path, std::vector<std::string>& dependencies) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (sources.count(path) > 0) {
+            return;
+          }
+        }
+        try {
+          detail::JSStringRefHolder js_source(source.read(path));
+          if (!EndsWith(path, ".json")) {
+            const std::string directory = GetDirectory(path);
+            for (const auto& id : ScanRequires(js_source.js_string_ref__)) {
+              std::string dependency;
+              if (Resolve(id, directory, dependency)) {
+                dependencies.push_back(std::move(dependency));
+              }
+            }
+          }
+          std::lock_guard<std::mutex> lock(mutex);
+          sources.emplace(path, std::move(js_source));
+        } catch (const std::exception& e) {
+          HAL_LOG_WARN("JSModuleLoader: can't preload ", path, ": ", e.what());
+        }
+      }
+
+      // Return a module's source, preloaded or not.
+      detail::JSStringRefHolder Read(const std::string& path) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          const auto position = sources.find(path);
+          if (position != sources.end()) {
+            detail::JSStringRefHolder js_source(std::move(position -> second));
+            sources.erase(position);
+            return js_source;
+          }
+        }
+        return detail::JSStringRefHolder(source.read(path));
+      }
+
+      // Parse a .json module.
+      JSValue ParseJSON(const std::string& path, JSStringRef js_source) const {
+        JSValueRef js_value_ref = JSValueMakeFromJSONString(static_cast<JSContextRef>(js_context), js_source);
+        if (!js_value_ref) {
+          detail::ThrowRuntimeError("JSModuleLoader", "can't parse " + path + " as JSON");
+        }
+        return JSValue(js_context, js_value_ref);
+      }
+
+      // Wrap a module in a function of exports, require, module,
+      // __filename and __dirname.
+      JSObject Compile(const std::string& path, JSStringRef js_source) const {
+        static const char* const kParameterNames[] = { "exports", "require", "module", "__filename", "__dirname" };
+        const std::size_t        kParameterCount   = sizeof(kParameterNames) / sizeof(kParameterNames[0]);
+
+        std::vector<detail::JSStringRefHolder> parameter_names;
+        std::vector<JSStringRef>               parameter_name_refs;
+        parameter_names.reserve(kParameterCount);
+        for (const auto parameter_name : kParameterNames) {
+          parameter_names.emplace_back(JSStringCreateWithUTF8CString(parameter_name));
+          parameter_name_refs.push_back(parameter_names.back().js_string_ref__);
+        }
+        const detail::JSStringRefHolder source_url(JSStringCreateWithUTF8CString(path.c_str()));
+
+        JSValueRef  exception { nullptr };
+        JSObjectRef js_object_ref = JSObjectMakeFunction(static_cast<JSContextRef>(js_context), nullptr, static_cast<unsigned>(kParameterCount), parameter_name_refs.data(), js_source, source_url.js_string_ref__, 1, &exception);
+        if (exception) {
+          detail::ThrowRuntimeError("JSModuleLoader", JSValue(js_context, exception), path, 1);
+        }
+        return static_cast<JSObject>(JSValue(js_context, js_object_ref));
+      }
+
+      // Modules in the same directory share a require function.
+      JSObject GetRequireFunction(const std::shared_ptr<State>& self, const std::string& directory) {
+        const auto position = require_functions.find(directory);
+        if (position != require_functions.end()) {
+          return position -> second;
+        }
+        const std::weak_ptr<State> weak_self = self;
+        const JSObject require = js_context.CreateFunction([weak_self, directory](const std::string& id) -> JSValue {
+          const auto state = weak_self.lock();
+          if (!state) {
+            detail::ThrowRuntimeError("JSModuleLoader", "require('" + id + "') called after its JSModuleLoader was destroyed");
+          }
+          return state -> Require(state, id, directory);
+        });
+        require_functions.emplace(directory, require);
+        return require;
+      }
+
+      JSValue Require(const std::shared_ptr<State>& self, const std::string& id, const std::string& directory) {
+        std::string path;
+        if (!Resolve(id, directory, path)) {
+          ThrowModuleNotFound(id, directory);
+        }
+
+        const auto exported = exports.find(path);
+        if (exported != exports.end()) {
+          return exported -> second;
+        }
+        const auto loading_module = loading.find(path);
+        if (loading_module != loading.end()) {
+          return loading_module -> second.GetProperty("exports");
+        }
+
+        const detail::JSStringRefHolder js_source(Read(path));
+        if (EndsWith(path, ".json")) {
+          const JSValue value = ParseJSON(path, js_source.js_string_ref__);
+          exports.emplace(path, value);
+          return value;
+        }
+
+        auto compiled = compiled_functions.find(path);
+        if (compiled == compiled_functions.end()) {
+          compiled = compiled_functions.emplace(path, Compile(path, js_source.js_string_ref__)).first;
+        }
+
+        const std::string module_directory = GetDirectory(path);
+        JSObject module        = js_context.CreateObject();
+        JSObject module_export = js_context.CreateObject();
+        module.SetProperty("id", js_context.CreateString(path));
+        module.SetProperty("filename", js_context.CreateString(path));
+        module.SetProperty("loaded", js_context.CreateBoolean(false));
+        module.SetProperty("exports", module_export);
+        loading.emplace(path, module);
+        try {
+          compiled -> second.Call(module_export, module_export, GetRequireFunction(self, module_directory), module, path, module_directory);
+        } catch (...) {
+          loading.erase(path);
+          throw;
+        }
+        module.SetProperty("loaded", js_context.CreateBoolean(true));
+        const JSValue value = module.GetProperty("exports");
+        loading.erase(path);
+        exports.emplace(path, value);
+        return value;
+      }
+
+      JSContext js_context;
+      Source    source;
+
+      // Shared with Preload's workers.
+      std::mutex                                   mutex;
+      std::unordered_map<std::string, bool>        probes;
+      std::unordered_map<std::string, std::string> package_mains;
+      std::unordered_map<std::string, std::string> resolutions;
+      std::unordered_map<std::string, detail::JSStringRefHolder> sources;
+      std::size_t                                  resolution_hits { 0 };
+
+      // Only used on the context's thread.
+      std::unordered_map<std::string, JSObject>    compiled_functions;
+      std::unordered_map<std::string, JSObject>    loading;
+      std::unordered_map<std::string, JSValue>     exports;
+      std::unordered_map<std::string, JSObject>    require_functions;
+    };
+
+    std::shared_ptr<State> state__;
+  };
+
+} // namespace HAL {
+
+#endif // _HAL_JSMODULELOADER_HPP_
@@ -0,0 +1,700 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSONWRITER_HPP_
+#define _HAL_JSONWRITER_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSValue.hpp"
+#include "HAL/detail/JSUtil.hpp"
+#include "HAL/detail/JSStringRefHolder.hpp"
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSONWriter serializes JavaScript values to UTF-8
+   encoded JSON by walking them natively through the JavaScriptCore C
+   API. Unlike JSValue::ToJSONString, the result is never
+   materialized as an intermediate UTF-16 JSString, and string data is
+   transcoded and escaped in a single pass directly into the output.
+
+   The output is either a caller-supplied std::string, which is
+   appended to in place, or a std::ostream, which receives the output
+   in chunks as it is produced so that large object graphs never need
+   to be held in memory all at once. Write may be called any number
+   of times on the same JSONWriter to serialize a sequence of values
+   incrementally.
+
+   The output follows the rules of JSON.stringify: toJSON methods are
+   called with the property name or array index as their key, Number,
+   String and Boolean objects are written as their primitive values,
+   only an object's own enumerable properties are written, in the
+   order of Object.keys, undefined and function valued properties are
+   omitted from objects and written as null in arrays, numbers are
+   written as Number.prototype.toString writes them and non-finite
+   numbers as null, and cyclic structures are rejected. Replacer
+   functions and property lists are not supported.
+
+   No script is compiled or evaluated. Arrays and Number, String and
+   Boolean objects are recognized with instanceof against the global
+   object's constructors, which are looked up once per global context,
+   so an array created in another global context is written as an
+   object. Their primitive values are read with valueOf and toString.
+
+   For example:
+
+   std::string buffer;
+   JSONWriter(buffer).Write(js_value);
+   */
+  class JSONWriter final {
+
+  public:
+
+    /*!
+     @method
+
+     @abstract Create a JSONWriter that appends its output to a
+     caller-supplied buffer.
+
+     @param buffer The std::string to append the UTF-8 encoded JSON
+     to.
+
+     @param indent The number of spaces to indent when nesting. If 0
+     (the default), the resulting JSON will not contain newlines. The
+     size of the indent is clamped to 10 spaces.
+     */
+    explicit JSONWriter(std::string& buffer, unsigned indent = 0) HAL_NOEXCEPT
+    : output__(buffer)
+    , indent__(std::min(indent, 10u)) {
+    }
+
+    /*!
+     @method
+
+     @abstract Create a JSONWriter that writes its output to a
+     std::ostream in chunks.
+
+     @param ostream The std::ostream to write the UTF-8 encoded JSON
+     to.
+
+     @param indent The number of spaces to indent when nesting. If 0
+     (the default), the resulting JSON will not contain newlines. The
+     size of the indent is clamped to 10 spaces.
+     */
+    explicit JSONWriter(std::ostream& ostream, unsigned indent = 0)
+    : output__(chunk__)
+    , ostream__(&ostream)
+    , indent__(std::min(indent, 10u)) {
+      chunk__.reserve(kChunkSize + 64);
+    }
+
+    /*!
+     @method
+
+     @abstract Serialize a JavaScript value and append it to the
+     output. Values that JSON.stringify would not serialize at the top
+     level (i.e. undefined and functions) produce no output.
+
+     @param js_value The JavaScript value to serialize.
+
+     @result A reference to this JSONWriter for chaining.
+
+     @throws std::runtime_error if the value contains a cycle, or if
+     calling a getter or toJSON method threw a JavaScript exception.
+     */
+    JSONWriter& Write(const JSValue& js_value) {
+      if (js_value.IsNativeNull()) {
+        Append("null", 4);
+      } else {
+        const auto js_context_ref = static_cast<JSContextRef>(js_value.get_context());
+        const auto value_ref      = ToJSON(js_context_ref, static_cast<JSValueRef>(js_value), empty_name_ref());
+        if (IsSerializable(js_context_ref, value_ref)) {
+          WriteValue(js_context_ref, value_ref);
+        }
+      }
+      MaybeFlush();
+      return *this;
+    }
+
+    /*!
+     @method
+
+     @abstract Write any output buffered for a std::ostream. This is
+     a no-op for a JSONWriter that appends to a std::string.
+     */
+    void Flush() {
+      if (ostream__ && !chunk__.empty()) {
+        ostream__ -> write(chunk__.data(), static_cast<std::streamsize>(chunk__.size()));
+        bytes_flushed__ += chunk__.size();
+        chunk__.clear();
+      }
+    }
+
+    /*!
+     @method
+
+     @abstract Return the number of UTF-8 bytes produced by this
+     JSONWriter so far.
+
+     @result The number of UTF-8 bytes produced so far.
+     */
+    std::size_t get_bytes_written() const HAL_NOEXCEPT {
+      return bytes_flushed__ + output__.size() - initial_size__;
+    }
+
+    ~JSONWriter() HAL_NOEXCEPT {
+      try {
+        Flush();
+      } catch (...) {
+        HAL_LOG_ERROR("JSONWriter: failed to flush output");
+      }
+      ReleaseBuiltins();
+    }
+
+    JSONWriter(const JSONWriter&)            = delete;
+    JSONWriter& operator=(const JSONWriter&) = delete;
+
+  private:
+
+    // The number of bytes buffered before they are written to a
+    // std::ostream.
+    static const std::size_t kChunkSize = 16 * 1024;
+
+    void Append(char c) {
+      output__.push_back(c);
+    }
+
+    void Append(const char* data, std::size_t length) {
+      output__.append(data, length);
+    }
+
+    void MaybeFlush() {
+      if (ostream__ && chunk__.size() >= kChunkSize) {
+        Flush();
+      }
+    }
+
+    void ThrowIfException(JSContextRef js_context_ref, JSValueRef exception) const {
+      if (exception) {
+        detail::ThrowRuntimeError("JSONWriter", JSValue(JSContext(js_context_ref), exception));
+      }
+    }
+
+    void WriteNewline(std::size_t depth) {
+      if (indent__ > 0) {
+        Append('\n');
+        output__.append(indent__ * depth, ' ');
+      }
+    }
+
+    // Apply the value's toJSON method, if it has one, as
+    // JSON.stringify does (e.g. for Date objects). The key is the
+    // property name, or the array index if key_ref is nullptr.
+    JSValueRef ToJSON(JSContextRef js_context_ref, JSValueRef value_ref, JSStringRef key_ref, unsigned index = 0) {
+      if (!JSValueIsObject(js_context_ref, value_ref)) {
+        return value_ref;
+      }
+
+      if (!to_json_name_ref__.js_string_ref__) {
+        to_json_name_ref__.js_string_ref__ = JSStringCreateWithUTF8CString("toJSON");
+      }
+
+      JSValueRef exception { nullptr };
+      JSObjectRef object_ref = JSValueToObject(js_context_ref, value_ref, &exception);
+      ThrowIfException(js_context_ref, exception);
+
+      JSValueRef to_json_ref = JSObjectGetProperty(js_context_ref, object_ref, to_json_name_ref__.js_string_ref__, &exception);
+      ThrowIfException(js_context_ref, exception);
+
+      if (!JSValueIsObject(js_context_ref, to_json_ref)) {
+        return value_ref;
+      }
+
+      JSObjectRef to_json_function_ref = JSValueToObject(js_context_ref, to_json_ref, &exception);
+      ThrowIfException(js_context_ref, exception);
+      if (!JSObjectIsFunction(js_context_ref, to_json_function_ref)) {
+        return value_ref;
+      }
+
+      JSValueRef arguments[1] { nullptr };
+      if (key_ref) {
+        arguments[0] = JSValueMakeString(js_context_ref, key_ref);
+      } else {
+        detail::JSStringRefHolder index_name(JSStringCreateWithUTF8CString(std::to_string(index).c_str()));
+        arguments[0] = JSValueMakeString(js_context_ref, index_name.js_string_ref__);
+      }
+      JSValueRef result_ref   = JSObjectCallAsFunction(js_context_ref, to_json_function_ref, object_ref, 1, arguments, &exception);
+      ThrowIfException(js_context_ref, exception);
+      return result_ref;
+    }
+
+    JSStringRef empty_name_ref() {
+      if (!empty_name_ref__.js_string_ref__) {
+        empty_name_ref__.js_string_ref__ = JSStringCreateWithUTF8CString("");
+      }
+      return empty_name_ref__.js_string_ref__;
+    }
+
+    bool IsSerializable(JSContextRef js_context_ref, JSValueRef value_ref) const {
+      if (value_ref == nullptr || JSValueIsUndefined(js_context_ref, value_ref)) {
+        return false;
+      }
+
+      if (JSValueIsObject(js_context_ref, value_ref)) {
+        JSObjectRef object_ref = JSValueToObject(js_context_ref, value_ref, nullptr);
+        return !JSObjectIsFunction(js_context_ref, object_ref);
+      }
+
+      return true;
+    }
+
+    // How an object is serialized.
+    enum class ObjectKind { Object, Array, Number, String, Boolean };
+
+    // Releases a JSPropertyNameArrayRef when it goes out of scope.
+    struct PropertyNames final {
+
+      explicit PropertyNames(JSPropertyNameArrayRef js_property_name_array_ref) HAL_NOEXCEPT
+      : js_property_name_array_ref__(js_property_name_array_ref) {
+      }
+
+      ~PropertyNames() HAL_NOEXCEPT {
+        JSPropertyNameArrayRelease(js_property_name_array_ref__);
+      }
+
+      PropertyNames(const PropertyNames&)            = delete;
+      PropertyNames& operator=(const PropertyNames&) = delete;
+
+      JSPropertyNameArrayRef js_property_name_array_ref__;
+    };
+
+    // Look up the built-ins used to classify objects, once per global
+    // context, and protect them from the garbage collector while this
+    // JSONWriter uses them.
+    void LoadBuiltins(JSContextRef js_context_ref) {
+      const JSGlobalContextRef js_global_context_ref = JSContextGetGlobalContext(js_context_ref);
+      if (builtins_context_ref__ == js_global_context_ref) {
+        return;
+      }
+      ReleaseBuiltins();
+
+      JSObjectRef global_object_ref = JSContextGetGlobalObject(js_context_ref);
+      const auto get_object = [this, js_context_ref](JSObjectRef object_ref, const char* name) {
+        detail::JSStringRefHolder name_ref(JSStringCreateWithUTF8CString(name));
+        JSValueRef exception { nullptr };
+        JSValueRef value_ref = JSObjectGetProperty(js_context_ref, object_ref, name_ref.js_string_ref__, &exception);
+        ThrowIfException(js_context_ref, exception);
+        JSObjectRef result_ref = JSValueToObject(js_context_ref, value_ref, &exception);
+        ThrowIfException(js_context_ref, exception);
+        return result_ref;
+      };
+      const JSObjectRef array_ref   = get_object(global_object_ref, "Array");
+      const JSObjectRef number_ref  = get_object(global_object_ref, "Number");
+      const JSObjectRef string_ref  = get_object(global_object_ref, "String");
+      const JSObjectRef boolean_ref = get_object(global_object_ref, "Boolean");
+      const JSObjectRef keys_ref    = get_object(get_object(global_object_ref, "Object"), "keys");
+
+      builtins__[kArray]   = array_ref;
+      builtins__[kNumber]  = number_ref;
+      builtins__[kString]  = string_ref;
+      builtins__[kBoolean] = boolean_ref;
+      builtins__[kKeys]    = keys_ref;
+      for (const auto builtin_ref : builtins__) {
+        JSValueProtect(js_context_ref, builtin_ref);
+      }
+      builtins_context_ref__ = JSGlobalContextRetain(js_global_context_ref);
+    }
+
+    void ReleaseBuiltins() HAL_NOEXCEPT {
+      if (builtins_context_ref__) {
+        for (auto& builtin_ref : builtins__) {
+          JSValueUnprotect(builtins_context_ref__, builtin_ref);
+          builtin_ref = nullptr;
+        }
+        JSGlobalContextRelease(builtins_context_ref__);
+        builtins_context_ref__ = nullptr;
+      }
+    }
+
+    bool IsInstanceOf(JSContextRef js_context_ref, JSObjectRef object_ref, JSObjectRef constructor_ref) const {
+      JSValueRef exception { nullptr };
+      const bool result = JSValueIsInstanceOfConstructor(js_context_ref, object_ref, constructor_ref, &exception);
+      ThrowIfException(js_context_ref, exception);
+      return result;
+    }
+
+    ObjectKind Classify(JSContextRef js_context_ref, JSObjectRef object_ref) {
+      LoadBuiltins(js_context_ref);
+      if (IsInstanceOf(js_context_ref, object_ref, builtins__[kArray])) {
+        return ObjectKind::Array;
+      }
+      if (IsInstanceOf(js_context_ref, object_ref, builtins__[kNumber])) {
+        return ObjectKind::Number;
+      }
+      if (IsInstanceOf(js_context_ref, object_ref, builtins__[kString])) {
+        return ObjectKind::String;
+      }
+      if (IsInstanceOf(js_context_ref, object_ref, builtins__[kBoolean])) {
+        return ObjectKind::Boolean;
+      }
+      return ObjectKind::Object;
+    }
+
+    void WriteValue(JSContextRef js_context_ref, JSValueRef value_ref) {
+      switch (JSValueGetType(js_context_ref, value_ref)) {
+        case kJSTypeUndefined:
+        case kJSTypeNull:
+          Append("null", 4);
+          break;
+
+        case kJSTypeBoolean:
+          if (JSValueToBoolean(js_context_ref, value_ref)) {
+            Append("true", 4);
+          } else {
+            Append("false", 5);
+          }
+          break;
+
+        case kJSTypeNumber:
+          WriteNumber(JSValueToNumber(js_context_ref, value_ref, nullptr));
+          break;
+
+        case kJSTypeString: {
+          JSValueRef exception { nullptr };
+          detail::JSStringRefHolder js_string(JSValueToStringCopy(js_context_ref, value_ref, &exception));
+          ThrowIfException(js_context_ref, exception);
+          WriteString(js_string.js_string_ref__);
+          break;
+        }
+
+        case kJSTypeObject: {
+          JSValueRef exception { nullptr };
+          JSObjectRef object_ref = JSValueToObject(js_context_ref, value_ref, &exception);
+          ThrowIfException(js_context_ref, exception);
+
+          const ObjectKind kind = Classify(js_context_ref, object_ref);
+
+          // Number, String and Boolean objects are converted the way
+          // JSON.stringify converts them, calling valueOf or toString.
+          // An object that only inherits from Number.prototype, say,
+          // throws a TypeError instead, and is written as an object.
+          if (kind == ObjectKind::Number || kind == ObjectKind::Boolean) {
+            const double number = JSValueToNumber(js_context_ref, object_ref, &exception);
+            if (!exception) {
+              if (kind == ObjectKind::Number) {
+                WriteNumber(number);
+              } else if (number != 0) {
+                Append("true", 4);
+              } else {
+                Append("false", 5);
+              }
+              break;
+            }
+          } else if (kind == ObjectKind::String) {
+            detail::JSStringRefHolder js_string(JSValueToStringCopy(js_context_ref, object_ref, &exception));
+            if (!exception) {
+              WriteString(js_string.js_string_ref__);
+              break;
+            }
+          }
+
+          if (std::find(stack__.begin(), stack__.end(), object_ref) != stack__.end()) {
+            detail::ThrowRuntimeError("JSONWriter", "Cannot serialize a cyclic structure to JSON");
+          }
+
+          stack__.push_back(object_ref);
+          if (kind == ObjectKind::Array) {
+            WriteArray(js_context_ref, object_ref);
+          } else {
+            WriteObject(js_context_ref, object_ref);
+          }
+          stack__.pop_back();
+          break;
+        }
+      }
+
+      MaybeFlush();
+    }
+
+    unsigned GetLength(JSContextRef js_context_ref, JSObjectRef array_ref) {
+      if (!length_name_ref__.js_string_ref__) {
+        length_name_ref__.js_string_ref__ = JSStringCreateWithUTF8CString("length");
+      }
+
+      JSValueRef exception { nullptr };
+      const double length_number = JSValueToNumber(js_context_ref, JSObjectGetProperty(js_context_ref, array_ref, length_name_ref__.js_string_ref__, &exception), &exception);
+      ThrowIfException(js_context_ref, exception);
+      return static_cast<unsigned>(detail::to_int32_t(length_number));
+    }
+
+    void WriteArray(JSContextRef js_context_ref, JSObjectRef array_ref) {
+      JSValueRef exception { nullptr };
+      const unsigned length = GetLength(js_context_ref, array_ref);
+
+      Append('[');
+      for (unsigned i = 0; i < length; ++i) {
+        if (i > 0) {
+          Append(',');
+        }
+        WriteNewline(stack__.size());
+
+        JSValueRef element_ref = JSObjectGetPropertyAtIndex(js_context_ref, array_ref, i, &exception);
+        ThrowIfException(js_context_ref, exception);
+        element_ref = ToJSON(js_context_ref, element_ref, nullptr, i);
+
+        if (IsSerializable(js_context_ref, element_ref)) {
+          WriteValue(js_context_ref, element_ref);
+        } else {
+          Append("null", 4);
+        }
+      }
+
+      if (length > 0) {
+        WriteNewline(stack__.size() - 1);
+      }
+      Append(']');
+    }
+
+    // Write the object's own enumerable properties, in the order of
+    // Object.keys.
+    //
+    // JSObjectCopyPropertyNames returns the names for-in visits: the
+    // object's own enumerable names, in the order of Object.keys,
+    // followed by the enumerable names it inherits. Objects almost
+    // never inherit any, so when the prototype chain has none the
+    // names are used as they are, and otherwise Object.keys is called.
+    void WriteObject(JSContextRef js_context_ref, JSObjectRef object_ref) {
+      bool first = true;
+      Append('{');
+
+      const JSValueRef prototype_ref = JSObjectGetPrototype(js_context_ref, object_ref);
+      bool inherits_names = false;
+      if (JSValueIsObject(js_context_ref, prototype_ref)) {
+        PropertyNames inherited_names(JSObjectCopyPropertyNames(js_context_ref, JSValueToObject(js_context_ref, prototype_ref, nullptr)));
+        inherits_names = JSPropertyNameArrayGetCount(inherited_names.js_property_name_array_ref__) > 0;
+      }
+
+      if (!inherits_names) {
+        PropertyNames names(JSObjectCopyPropertyNames(js_context_ref, object_ref));
+        const std::size_t count = JSPropertyNameArrayGetCount(names.js_property_name_array_ref__);
+        for (std::size_t i = 0; i < count; ++i) {
+          WriteProperty(js_context_ref, object_ref, JSPropertyNameArrayGetNameAtIndex(names.js_property_name_array_ref__, i), first);
+        }
+      } else {
+        JSValueRef exception { nullptr };
+        JSValueRef arguments[1] = { object_ref };
+        JSValueRef keys_value_ref = JSObjectCallAsFunction(js_context_ref, builtins__[kKeys], nullptr, 1, arguments, &exception);
+        ThrowIfException(js_context_ref, exception);
+        JSObjectRef keys_ref = JSValueToObject(js_context_ref, keys_value_ref, &exception);
+        ThrowIfException(js_context_ref, exception);
+
+        const unsigned count = GetLength(js_context_ref, keys_ref);
+        for (unsigned i = 0; i < count; ++i) {
+          JSValueRef key_ref = JSObjectGetPropertyAtIndex(js_context_ref, keys_ref, i, &exception);
+          ThrowIfException(js_context_ref, exception);
+          detail::JSStringRefHolder name(JSValueToStringCopy(js_context_ref, key_ref, &exception));
+          ThrowIfException(js_context_ref, exception);
+          WriteProperty(js_context_ref, object_ref, name.js_string_ref__, first);
+        }
+      }
+
+      if (!first) {
+        WriteNewline(stack__.size() - 1);
+      }
+      Append('}');
+    }
+
+    void WriteProperty(JSContextRef js_context_ref, JSObjectRef object_ref, JSStringRef name_ref, bool& first) {
+      JSValueRef exception { nullptr };
+      JSValueRef property_ref = JSObjectGetProperty(js_context_ref, object_ref, name_ref, &exception);
+      ThrowIfException(js_context_ref, exception);
+      property_ref = ToJSON(js_context_ref, property_ref, name_ref);
+
+      if (!IsSerializable(js_context_ref, property_ref)) {
+        return;
+      }
+
+      if (!first) {
+        Append(',');
+      }
+      first = false;
+
+      WriteNewline(stack__.size());
+      WriteString(name_ref);
+      Append(':');
+      if (indent__ > 0) {
+        Append(' ');
+      }
+      WriteValue(js_context_ref, property_ref);
+    }
+
+    void WriteNumber(double number) {
+      // JSON has no representation for NaN or the infinities.
+      if (!std::isfinite(number)) {
+        Append("null", 4);
+        return;
+      }
+
+      if (number == 0) {
+        // This also writes -0 as 0, matching JSON.stringify.
+        Append('0');
+        return;
+      }
+      if (number < 0) {
+        Append('-');
+        number = -number;
+      }
+
+      char buffer[32];
+      if (number < 9007199254740992.0 && std::floor(number) == number) {
+        // Integers below 2^53 are exact, and so are their own shortest
+        // representation.
+        const int length = std::snprintf(buffer, sizeof(buffer), "%.0f", number);
+        Append(buffer, static_cast<std::size_t>(length));
+        return;
+      }
+
+      // Find the fewest significant digits that round-trip. If p
+      // digits do then so do p + 1, so the search can be binary.
+      int first_precision = 1;
+      int last_precision  = 17;
+      while (first_precision < last_precision) {
+        const int precision = first_precision + (last_precision - first_precision) / 2;
+        std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, number);
+        if (std::strtod(buffer, nullptr) == number) {
+          last_precision = precision;
+        } else {
+          first_precision = precision + 1;
+        }
+      }
+      std::snprintf(buffer, sizeof(buffer), "%.*e", first_precision - 1, number);
+
+      // Split d.ddde[+-]x into its digits and exponent.
+      char digits[20];
+      int  k = 0;
+      const char* p = buffer;
+      for (; *p != 'e'; ++p) {
+        if (*p != '.') {
+          digits[k++] = *p;
+        }
+      }
+      while (k > 1 && digits[k - 1] == '0') {
+        --k;
+      }
+      const int n = std::atoi(p + 1) + 1;
+
+      // Lay the digits out the way Number::toString does (ECMA-262,
+      // section 6.1.6.1.20), where the value is 0.digits x 10^n.
+      if (k <= n && n <= 21) {
+        Append(digits, static_cast<std::size_t>(k));
+        output__.append(static_cast<std::size_t>(n - k), '0');
+      } else if (0 < n && n <= 21) {
+        Append(digits, static_cast<std::size_t>(n));
+        Append('.');
+        Append(digits + n, static_cast<std::size_t>(k - n));
+      } else if (-6 < n && n <= 0) {
+        Append("0.", 2);
+        output__.append(static_cast<std::size_t>(-n), '0');
+        Append(digits, static_cast<std::size_t>(k));
+      } else {
+        Append(digits[0]);
+        if (k > 1) {
+          Append('.');
+          Append(digits + 1, static_cast<std::size_t>(k - 1));
+        }
+        const int length = std::snprintf(buffer, sizeof(buffer), "e%+d", n - 1);
+        Append(buffer, static_cast<std::size_t>(length));
+      }
+    }
+
+    // Escape and transcode a UTF-16 JSStringRef to UTF-8 in a single
+    // pass.
+    void WriteString(JSStringRef js_string_ref) {
+      static const char hex_digits[] = "0123456789abcdef";
+
+      const JSChar*     characters = JSStringGetCharactersPtr(js_string_ref);
+      const std::size_t length     = JSStringGetLength(js_string_ref);
+
+      Append('"');
+      for (std::size_t i = 0; i < length; ++i) {
+        const std::uint32_t code_unit = characters[i];
+
+        if (code_unit < 0x80) {
+          switch (code_unit) {
+            case '"':  Append("\\\"", 2); break;
+            case '\\': Append("\\\\", 2); break;
+            case '\b': Append("\\b", 2);  break;
+            case '\f': Append("\\f", 2);  break;
+            case '\n': Append("\\n", 2);  break;
+            case '\r': Append("\\r", 2);  break;
+            case '\t': Append("\\t", 2);  break;
+            default:
+              if (code_unit < 0x20) {
+                const char escape[] = { '\\', 'u', '0', '0', hex_digits[code_unit >> 4], hex_digits[code_unit & 0xF] };
+                Append(escape, sizeof(escape));
+              } else {
+                Append(static_cast<char>(code_unit));
+              }
+          }
+        } else if (code_unit < 0x800) {
+          Append(static_cast<char>(0xC0 | (code_unit >> 6)));
+          Append(static_cast<char>(0x80 | (code_unit & 0x3F)));
+        } else if (code_unit >= 0xD800 && code_unit <= 0xDFFF) {
+          const bool is_pair = code_unit <= 0xDBFF && i + 1 < length && characters[i + 1] >= 0xDC00 && characters[i + 1] <= 0xDFFF;
+          if (is_pair) {
+            const std::uint32_t code_point = 0x10000 + ((code_unit - 0xD800) << 10) + (characters[++i] - 0xDC00);
+            Append(static_cast<char>(0xF0 | (code_point >> 18)));
+            Append(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            Append(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            Append(static_cast<char>(0x80 | (code_point & 0x3F)));
+          } else {
+            // Lone surrogates are escaped so that the output is
+            // always well-formed UTF-8.
+            const char escape[] = { '\\', 'u', hex_digits[(code_unit >> 12) & 0xF], hex_digits[(code_unit >> 8) & 0xF], hex_digits[(code_unit >> 4) & 0xF], hex_digits[code_unit & 0xF] };
+            Append(escape, sizeof(escape));
+          }
+        } else {
+          Append(static_cast<char>(0xE0 | (code_unit >> 12)));
+          Append(static_cast<char>(0x80 | ((code_unit >> 6) & 0x3F)));
+          Append(static_cast<char>(0x80 | (code_unit & 0x3F)));
+        }
+      }
+      Append('"');
+    }
+
+    std::string              chunk__;
+    std::string&             output__;
+    std::ostream*            ostream__ { nullptr };
+    unsigned                 indent__  { 0 };
+    std::size_t              initial_size__ { output__.size() };
+    std::size_t              bytes_flushed__ { 0 };
+    std::vector<JSObjectRef> stack__;
+    enum { kArray, kNumber, kString, kBoolean, kKeys, kBuiltinCount };
+
+    JSGlobalContextRef       builtins_context_ref__ { nullptr };
+    JSObjectRef              builtins__[kBuiltinCount] = { };
+    detail::JSStringRefHolder to_json_name_ref__ { nullptr };
+    detail::JSStringRefHolder length_name_ref__  { nullptr };
+    detail::JSStringRefHolder empty_name_ref__   { nullptr };
+  };
+
+} // namespace HAL {
+
+#endif // _HAL_JSONWRITER_HPP_
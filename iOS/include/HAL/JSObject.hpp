@@ -13,11 +13,16 @@
 #include "HAL/JSContext.hpp"
 #include "HAL/JSPropertyAttribute.hpp"
 #include "HAL/JSPropertyNameArray.hpp"
+#include "HAL/detail/JSExportPrivateData.hpp"
 
 #include <memory>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <type_traits>
 
 namespace HAL {
   class JSString;
@@ -25,14 +30,21 @@ namespace HAL {
   class JSClass;
   class JSPropertyNameAccumulator;
   class JSPropertyNameArray;
+  class JSPropertyView;
   class JSArray;
   class JSError;
   
   class JSExportObject;
   
+  template<typename T>
+  class JSResult;
+  
   namespace detail {
     template<typename T>
     class JSExportClass;
+    
+    template<typename T, typename Enable>
+    struct JSValueConverter;
   }
 }
 
@@ -104,6 +116,44 @@ namespace HAL {
      */
     virtual JSValue GetProperty(unsigned property_index) const final;
     
+    /*!
+     @method
+     
+     @abstract Return a property of this JavaScript object, returning
+     rather than throwing a JavaScript exception.
+     
+     @param property_name The name of the property to get.
+     
+     @result A JSResult holding the property's value, or a
+     JSNativeError holding the JavaScript exception if getting the
+     property threw one.
+     */
+    JSResult<JSValue> TryGetProperty(const JSString& property_name) const;
+    
+    /*!
+     @method
+     
+     @abstract Return several properties of this JavaScript object at
+     once.
+     
+     @discussion This is equivalent to calling GetProperty for each
+     name in turn, but crosses into JavaScriptCore without creating
+     any intermediate wrappers, and reserves the result only once.
+     
+     @param property_names A range of JSString property names, such as
+     a std::vector<JSString> or a std::array<JSString, N>.
+     
+     @result The property values in the same order as property_names.
+     A property that is not set has the value undefined.
+     
+     @throws std::runtime_error if getting any property threw a
+     JavaScript exception.
+     */
+    template<typename PropertyNameRange>
+    std::vector<JSValue> GetProperties(const PropertyNameRange& property_names) const;
+    
+    std::vector<JSValue> GetProperties(std::initializer_list<JSString> property_names) const;
+    
     /*!
      @method
      
@@ -115,7 +165,8 @@ namespace HAL {
      @param value The value of the the property to set.
      
      @param attributes An optional set of property attributes to give
-     to the property.
+     to the property. The JSPropertyAttributes overload below does
+     not build a set.
      
      @result true if the the property was set.
      
@@ -124,6 +175,36 @@ namespace HAL {
      */
     virtual void SetProperty(const JSString& property_name, const JSValue& property_value, const std::unordered_set<JSPropertyAttribute>& attributes = {}) final;
     
+    /*!
+     @method
+     
+     @abstract Set a property on this JavaScript object with the given
+     attributes.
+     
+     @discussion For example:
+     
+     js_object.SetProperty("x", js_value, JSPropertyAttribute::ReadOnly | JSPropertyAttribute::DontDelete);
+     js_object.SetProperty("x", js_value, {JSPropertyAttribute::ReadOnly, JSPropertyAttribute::DontDelete});
+     
+     @param property_name The name of the property to set.
+     
+     @param value The value of the the property to set.
+     
+     @param attributes The JSPropertyAttributes, a single
+     JSPropertyAttribute or a braced list of them to give to the
+     property.
+     
+     @throws std::runtime_error if setting the property threw a
+     JavaScript exception.
+     */
+    void SetProperty(const JSString& property_name, const JSValue& property_value, JSPropertyAttributes attributes);
+    
+    // Braced lists of attributes pick this overload rather than the
+    // std::unordered_set one.
+    void SetProperty(const JSString& property_name, const JSValue& property_value, std::initializer_list<JSPropertyAttribute> attributes) {
+      SetProperty(property_name, property_value, JSPropertyAttributes(attributes));
+    }
+    
     /*!
      @method
      
@@ -142,6 +223,42 @@ namespace HAL {
      */
     virtual void SetProperty(unsigned property_index, const JSValue& property_value) final;
     
+    /*!
+     @method
+     
+     @abstract Set several properties on this JavaScript object at
+     once.
+     
+     @discussion This is equivalent to calling SetProperty for each
+     name and value pair in turn, but the property attributes are
+     converted only once, and no intermediate wrappers are created for
+     each property. This is the preferred way to populate an object
+     with many fields.
+     
+     For example:
+     
+     js_object.SetProperties({
+       { "x"    , js_context.CreateNumber(1) },
+       { "y"    , js_context.CreateNumber(2) },
+       { "label", js_context.CreateString("origin") }
+     });
+     
+     @param properties A range of std::pair<JSString, JSValue>, such
+     as a std::vector or a std::initializer_list, that are set in
+     order.
+     
+     @param attributes Optional property attributes to give to every
+     property.
+     
+     @throws std::runtime_error if setting any property threw a
+     JavaScript exception. Properties preceding the one that threw
+     remain set.
+     */
+    template<typename PropertyRange>
+    void SetProperties(const PropertyRange& properties, JSPropertyAttributes attributes = JSPropertyAttributes());
+    
+    void SetProperties(std::initializer_list<std::pair<JSString, JSValue>> properties, JSPropertyAttributes attributes = JSPropertyAttributes());
+    
     /*!
      @method
      
@@ -173,8 +290,42 @@ namespace HAL {
      @abstract Return the set of this JavaScript object's enumerable properties.
      
      @result A unordered_map containing the names and values of object's enumerable properties.
+     
+     @discussion This converts every name and value up front. Use
+     GetPropertyView or ForEachProperty to visit the properties in
+     enumeration order without building a map.
      */
     virtual std::unordered_map<std::string, JSValue> GetProperties() const HAL_NOEXCEPT final;
+    
+    /*!
+     @method
+     
+     @abstract Return a lazy, ordered view of this JavaScript object's
+     enumerable properties.
+     
+     @discussion Only the property names are captured when the view
+     is created. Each name and value is converted only when it is
+     accessed through the view.
+     
+     @result A JSPropertyView of this object's enumerable properties
+     in enumeration order.
+     */
+    JSPropertyView GetPropertyView() const HAL_NOEXCEPT;
+    
+    /*!
+     @method
+     
+     @abstract Call a function for each of this JavaScript object's
+     enumerable properties, in enumeration order.
+     
+     @param callback A callable invoked as callback(const JSString&
+     name, const JSValue& value) for each property.
+     
+     @throws std::runtime_error if getting a property threw a
+     JavaScript exception, and anything thrown by callback.
+     */
+    template<typename Callback>
+    void ForEachProperty(Callback&& callback) const;
 
 
     /*!
@@ -237,6 +388,51 @@ namespace HAL {
     virtual JSValue operator()(const std::vector<JSValue>&  arguments, JSObject this_object) final;
     virtual JSValue operator()(const std::vector<JSString>& arguments, JSObject this_object) final;
     
+    /*!
+     @method
+     
+     @abstract Call this JavaScript object as a function with a
+     this_object of a class derived from JSObject, such as JSArray or
+     JSFunction, without copying it.
+     
+     @discussion The overloads above take this_object by value, so a
+     derived this_object would be sliced into a copy of a JSObject.
+     These are a better match for it and pass it on by reference.
+     Passing a JSObject itself still calls the overloads above, which
+     move it if it is an rvalue.
+     
+     @throws std::runtime_error under the same conditions as the
+     overloads above.
+     */
+    template<typename U, typename = typename std::enable_if<std::is_base_of<JSObject, U>::value>::type>
+    JSValue operator()(const U& this_object);
+    template<typename U, typename = typename std::enable_if<std::is_base_of<JSObject, U>::value>::type>
+    JSValue operator()(JSValue& argument, const U& this_object);
+    template<typename U, typename = typename std::enable_if<std::is_base_of<JSObject, U>::value>::type>
+    JSValue operator()(const JSString& argument, const U& this_object);
+    template<typename U, typename = typename std::enable_if<std::is_base_of<JSObject, U>::value>::type>
+    JSValue operator()(const std::vector<JSValue>& arguments, const U& this_object);
+    template<typename U, typename = typename std::enable_if<std::is_base_of<JSObject, U>::value>::type>
+    JSValue operator()(const std::vector<JSString>& arguments, const U& this_object);
+    
+    /*!
+     @method
+     
+     @abstract Call this JavaScript object as a function, returning
+     rather than throwing a JavaScript exception.
+     
+     @param arguments The JSValue arguments to pass to the function.
+     
+     @param this_object An optional JavaScript object to use as
+     'this'. The default value is the global object.
+     
+     @result A JSResult holding the function's return value, or a
+     JSNativeError if this JavaScript object can't be called as a
+     function or calling it threw a JavaScript exception.
+     */
+    JSResult<JSValue> TryCallAsFunction(const std::vector<JSValue>& arguments) const;
+    JSResult<JSValue> TryCallAsFunction(const std::vector<JSValue>& arguments, const JSObject& this_object) const;
+    
     /*!
      @method
      
@@ -268,6 +464,49 @@ namespace HAL {
     virtual JSObject CallAsConstructor(const std::vector<JSString>& arguments) final;
     virtual JSObject CallAsConstructor(const std::vector<JSValue>&  arguments) final;
     
+    /*!
+     @method
+     
+     @abstract Call this JavaScript object as a function with any
+     number of arguments, for example fn.Call(this_object, 1.0, "str",
+     js_object).
+     
+     @discussion Each argument is converted with JSValueConverter
+     straight into a JSValueRef array on the stack, and the function is
+     called with one JavaScriptCore C API call, so no heap memory is
+     allocated for the arguments.
+     
+     @param this_object The JavaScript object to use as 'this'.
+     
+     @param arguments The arguments to pass to the function. Any type
+     with a JSValueConverter can be passed, as well as string literals
+     and classes derived from JSValue or JSObject.
+     
+     @result Return the function's return value.
+     
+     @throws std::runtime_error if either this JavaScript object can't
+     be called as a function, or converting an argument or calling the
+     function itself threw a JavaScript exception.
+     */
+    template<typename... Arguments>
+    JSValue Call(const JSObject& this_object, const Arguments&... arguments) const;
+    
+    /*!
+     @method
+     
+     @abstract Call this JavaScript object as a constructor as if in a
+     'new' expression with any number of arguments, converting them
+     the same way as Call.
+     
+     @result The JavaScript object of the constructor's return value.
+     
+     @throws std::runtime_error if either this JavaScript object can't
+     be called as a constructor, or converting an argument or calling
+     the constructor itself threw a JavaScript exception.
+     */
+    template<typename... Arguments>
+    JSObject Construct(const Arguments&... arguments) const;
+    
     /*!
      @method
      
@@ -328,14 +567,20 @@ namespace HAL {
     /*!
      @method
      
-     @abstract Return a std::shared_ptr<T> to this object's private
-     data.
+     @abstract Return a pointer to this object's private data.
+     
+     @discussion The native object is owned by the JavaScript object,
+     so the pointer is valid for as long as this JSObject is. This
+     doesn't allocate, and when the native object was created as a T
+     it doesn't cast either: every JSExportClass stamps its native
+     objects with a type id that is compared here.
      
-     @result A std::shared_ptr<T> to this object's private data if the
-     object has private data of type T*, otherwise nullptr.
+     @result A pointer to this object's private data if the object
+     was created by JSExport<T>, or by a JSExport class whose parent
+     class chain includes JSExport<T>, otherwise nullptr.
      */
     template<typename T>
-    std::shared_ptr<T> GetPrivate() const HAL_NOEXCEPT;
+    T* GetPrivate() const HAL_NOEXCEPT;
     
     
     virtual ~JSObject()            HAL_NOEXCEPT;
@@ -365,6 +610,12 @@ namespace HAL {
     
     // These classes need access to operator JSObjectRef().
     friend class JSPropertyNameArray;
+    friend class JSPropertyView;
+    
+    // JSValueConverter needs access to operator JSObjectRef() and the
+    // JSObject constructor above.
+    template<typename T, typename Enable>
+    friend struct detail::JSValueConverter;
     
     // For interoperability with the JavaScriptCore C API.
     explicit operator JSObjectRef() const HAL_NOEXCEPT {
@@ -461,17 +712,22 @@ namespace HAL {
     static std::unordered_map<std::intptr_t, std::intptr_t> js_private_data_to_js_object_ref_map__;
 #pragma warning(pop)
 
+    // JSLeakDetector reports the static maps' entries.
+    friend class JSLeakDetector;
+
+    // The static maps are shared by every context group, and so by
+    // every executor thread.
+    static std::recursive_mutex& GetStaticMutex() HAL_NOEXCEPT {
+      static std::recursive_mutex mutex_static;
+      return mutex_static;
+    }
+    
+    // A JSObject belongs to the thread of its context group's executor,
+    // so it doesn't lock. Debug builds check the calling thread.
 #undef  HAL_JSOBJECT_LOCK_GUARD
 #undef  HAL_JSOBJECT_LOCK_GUARD_STATIC
-#ifdef  HAL_THREAD_SAFE
-           std::recursive_mutex mutex__;
-    static std::recursive_mutex mutex_static__;
-#define HAL_JSOBJECT_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock(mutex__)
-#define HAL_JSOBJECT_LOCK_GUARD_STATIC std::lock_guard<std::recursive_mutex> lock_static(JSObject::mutex_static__)
-#else
-#define HAL_JSOBJECT_LOCK_GUARD
-#define HAL_JSOBJECT_LOCK_GUARD_STATIC
-#endif  // HAL_THREAD_SAFE
+#define HAL_JSOBJECT_LOCK_GUARD HAL_DETAIL_JSTHREADCONFINEMENT_CHECK(static_cast<JSContextRef>(js_context__))
+#define HAL_JSOBJECT_LOCK_GUARD_STATIC std::lock_guard<std::recursive_mutex> lock_static(JSObject::GetStaticMutex())
   };
   
   inline
@@ -480,10 +736,97 @@ namespace HAL {
   }
   
   template<typename T>
-  std::shared_ptr<T> JSObject::GetPrivate() const HAL_NOEXCEPT {
-    return std::shared_ptr<T>(std::make_shared<JSObject>(*this), dynamic_cast<T*>(static_cast<JSExportObject*>(GetPrivate())));
+  T* JSObject::GetPrivate() const HAL_NOEXCEPT {
+    using PrivateData = detail::JSExportPrivateData<T>;
+    void* private_data = PrivateData::Find(static_cast<JSContextRef>(js_context__), js_object_ref__);
+    if (private_data == nullptr) {
+      return nullptr;
+    }
+    
+    if (PrivateData::IsExactly(private_data)) {
+      return static_cast<T*>(private_data);
+    }
+    
+    // The native object is a JavaScript subclass of T's class, so it
+    // is some class derived from T.
+    return dynamic_cast<T*>(static_cast<JSExportObject*>(private_data));
   }
   
 } // namespace HAL {
 
+// The inline property methods below need the complete JSString and
+// JSValue types.
+#include "HAL/JSString.hpp"
+#include "HAL/JSValue.hpp"
+#include "HAL/detail/JSUtil.hpp"
+
+namespace HAL {
+  
+  template<typename PropertyNameRange>
+  std::vector<JSValue> JSObject::GetProperties(const PropertyNameRange& property_names) const {
+    HAL_JSOBJECT_LOCK_GUARD;
+    const auto js_context_ref = static_cast<JSContextRef>(js_context__);
+    std::vector<JSValue> property_values;
+    property_values.reserve(std::distance(std::begin(property_names), std::end(property_names)));
+    JSValueRef exception { nullptr };
+    for (const auto& property_name : property_names) {
+      JSValueRef js_value_ref = JSObjectGetProperty(js_context_ref, js_object_ref__, static_cast<JSStringRef>(property_name), &exception);
+      if (exception) {
+        detail::ThrowRuntimeError("JSObject", JSValue(js_context__, exception));
+      }
+      property_values.push_back(JSValue(js_context__, js_value_ref));
+    }
+    return property_values;
+  }
+  
+  inline
+  std::vector<JSValue> JSObject::GetProperties(std::initializer_list<JSString> property_names) const {
+    return GetProperties<std::initializer_list<JSString>>(property_names);
+  }
+  
+  inline
+  void JSObject::SetProperty(const JSString& property_name, const JSValue& property_value, JSPropertyAttributes attributes) {
+    HAL_JSOBJECT_LOCK_GUARD;
+    JSValueRef exception { nullptr };
+    JSObjectSetProperty(static_cast<JSContextRef>(js_context__), js_object_ref__, static_cast<JSStringRef>(property_name), static_cast<JSValueRef>(property_value), static_cast<::JSPropertyAttributes>(attributes), &exception);
+    if (exception) {
+      detail::ThrowRuntimeError("JSObject", JSValue(js_context__, exception));
+    }
+  }
+  
+  template<typename PropertyRange>
+  void JSObject::SetProperties(const PropertyRange& properties, JSPropertyAttributes attributes) {
+    HAL_JSOBJECT_LOCK_GUARD;
+    const auto js_context_ref         = static_cast<JSContextRef>(js_context__);
+    const auto js_property_attributes = static_cast<::JSPropertyAttributes>(attributes);
+    JSValueRef exception { nullptr };
+    for (const auto& property : properties) {
+      JSObjectSetProperty(js_context_ref, js_object_ref__, static_cast<JSStringRef>(property.first), static_cast<JSValueRef>(property.second), js_property_attributes, &exception);
+      if (exception) {
+        detail::ThrowRuntimeError("JSObject", JSValue(js_context__, exception));
+      }
+    }
+  }
+  
+  inline
+  void JSObject::SetProperties(std::initializer_list<std::pair<JSString, JSValue>> properties, JSPropertyAttributes attributes) {
+    SetProperties<std::initializer_list<std::pair<JSString, JSValue>>>(properties, attributes);
+  }
+  
+} // namespace HAL {
+
+// JSPropertyView defines GetPropertyView and ForEachProperty.
+#include "HAL/JSPropertyView.hpp"
+
+// JSValueConverter defines Call and Construct, and JSContext's
+// CreateFunction for C++ callables.
+#include "HAL/detail/JSValueConverter.hpp"
+
+// JSResult defines TryGetProperty, TryCallAsFunction and JSContext's
+// TryEvaluateScript.
+#include "HAL/JSResult.hpp"
+
+// JSContextGroupExecutor defines JSContextGroup's Post and Invoke.
+#include "HAL/JSContextGroupExecutor.hpp"
+
 #endif // _HAL_JSOBJECT_HPP_
@@ -9,8 +9,13 @@
 #ifndef _HAL_JSPROPERTYATTRIBUTE_HPP_
 #define _HAL_JSPROPERTYATTRIBUTE_HPP_
 
+#include "HAL/detail/JSBase.hpp"
+
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <unordered_set>
 
 namespace HAL {
 
@@ -57,4 +62,117 @@ struct hash<JSPropertyAttribute> {
 
 }  // namespace std {
 
+namespace HAL {
+
+/*!
+  @class
+  
+  @discussion A JSPropertyAttributes is a set of JSPropertyAttribute
+  values represented as a bitmask with the same layout as the
+  JavaScriptCore C API JSPropertyAttributes, so converting between the
+  two has no cost. All of its operations are constexpr and none of
+  them allocate.
+  
+  A JSPropertyAttributes is implicitly constructible from a single
+  JSPropertyAttribute, from a braced list of them, and, for
+  compatibility with existing code, from a
+  std::unordered_set<JSPropertyAttribute>.
+  
+  For example:
+  
+  js_object.SetProperty("x", js_value, JSPropertyAttribute::ReadOnly | JSPropertyAttribute::DontEnum);
+*/
+class JSPropertyAttributes final {
+	
+public:
+	
+	constexpr JSPropertyAttributes() HAL_NOEXCEPT
+	: js_property_attributes__(kJSPropertyAttributeNone) {
+	}
+	
+	constexpr JSPropertyAttributes(JSPropertyAttribute attribute) HAL_NOEXCEPT
+	: js_property_attributes__(ToBit(attribute)) {
+	}
+	
+	JSPropertyAttributes(std::initializer_list<JSPropertyAttribute> attributes) HAL_NOEXCEPT
+	: js_property_attributes__(kJSPropertyAttributeNone) {
+		for (const auto attribute : attributes) {
+			js_property_attributes__ |= ToBit(attribute);
+		}
+	}
+	
+	JSPropertyAttributes(const std::unordered_set<JSPropertyAttribute>& attributes) HAL_NOEXCEPT
+	: js_property_attributes__(kJSPropertyAttributeNone) {
+		for (const auto attribute : attributes) {
+			js_property_attributes__ |= ToBit(attribute);
+		}
+	}
+	
+	// For interoperability with the JavaScriptCore C API.
+	explicit constexpr JSPropertyAttributes(::JSPropertyAttributes js_property_attributes) HAL_NOEXCEPT
+	: js_property_attributes__(js_property_attributes) {
+	}
+	
+	// For interoperability with the JavaScriptCore C API.
+	explicit constexpr operator ::JSPropertyAttributes() const HAL_NOEXCEPT {
+		return js_property_attributes__;
+	}
+	
+	/*!
+	  @method
+	  
+	  @abstract Return true if the given attribute is in this set.
+	  JSPropertyAttribute::None is in every set.
+	*/
+	constexpr bool Has(JSPropertyAttribute attribute) const HAL_NOEXCEPT {
+		return (js_property_attributes__ & ToBit(attribute)) == ToBit(attribute);
+	}
+	
+	// For compatibility with APIs that take a
+	// std::unordered_set<JSPropertyAttribute>.
+	std::unordered_set<JSPropertyAttribute> to_unordered_set() const {
+		std::unordered_set<JSPropertyAttribute> attributes;
+		for (const auto attribute : { JSPropertyAttribute::ReadOnly, JSPropertyAttribute::DontEnum, JSPropertyAttribute::DontDelete }) {
+			if (Has(attribute)) {
+				attributes.insert(attribute);
+			}
+		}
+		return attributes;
+	}
+	
+	constexpr JSPropertyAttributes operator|(JSPropertyAttributes rhs) const HAL_NOEXCEPT {
+		return JSPropertyAttributes(js_property_attributes__ | rhs.js_property_attributes__);
+	}
+	
+	JSPropertyAttributes& operator|=(JSPropertyAttributes rhs) HAL_NOEXCEPT {
+		js_property_attributes__ |= rhs.js_property_attributes__;
+		return *this;
+	}
+	
+	constexpr bool operator==(JSPropertyAttributes rhs) const HAL_NOEXCEPT {
+		return js_property_attributes__ == rhs.js_property_attributes__;
+	}
+	
+	constexpr bool operator!=(JSPropertyAttributes rhs) const HAL_NOEXCEPT {
+		return js_property_attributes__ != rhs.js_property_attributes__;
+	}
+	
+private:
+	
+	static constexpr ::JSPropertyAttributes ToBit(JSPropertyAttribute attribute) HAL_NOEXCEPT {
+		return attribute == JSPropertyAttribute::ReadOnly   ? kJSPropertyAttributeReadOnly   :
+		       attribute == JSPropertyAttribute::DontEnum   ? kJSPropertyAttributeDontEnum   :
+		       attribute == JSPropertyAttribute::DontDelete ? kJSPropertyAttributeDontDelete :
+		                                                      kJSPropertyAttributeNone;
+	}
+	
+	::JSPropertyAttributes js_property_attributes__;
+};
+
+constexpr JSPropertyAttributes operator|(JSPropertyAttribute lhs, JSPropertyAttribute rhs) HAL_NOEXCEPT {
+	return JSPropertyAttributes(lhs) | JSPropertyAttributes(rhs);
+}
+
+} // namespace HAL {
+
 #endif // _HAL_JSPROPERTYATTRIBUTE_HPP_
@@ -103,13 +103,10 @@ namespace HAL {
     JSPropertyNameArrayRef js_property_name_array_ref__;
 #pragma warning(pop)
     
+    // A JSPropertyNameArrayRef isn't changed once created, so there is
+    // nothing to check.
 #undef  HAL_JSPROPERTYNAMEARRAY_LOCK_GUARD
-#ifdef  HAL_THREAD_SAFE
-    std::recursive_mutex mutex__;
-#define HAL_JSPROPERTYNAMEARRAY_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock(mutex__)
-#else
 #define HAL_JSPROPERTYNAMEARRAY_LOCK_GUARD
-#endif  // HAL_THREAD_SAFE
   };
   
   inline
@@ -0,0 +1,267 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSPROPERTYVIEW_HPP_
+#define _HAL_JSPROPERTYVIEW_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSObject.hpp"
+#include "HAL/JSString.hpp"
+#include "HAL/JSValue.hpp"
+#include "HAL/detail/JSUtil.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSPropertyView is a lazy, ordered view of the
+   enumerable properties of a JavaScript object. It takes a snapshot
+   of the property names when it is created, in the object's
+   enumeration order, and nothing else: a property's name and value
+   are only converted to a JSString and JSValue when they are asked
+   for.
+
+   For example:
+
+   for (const auto property : js_object.GetPropertyView()) {
+     if (property.get_name() == "width") {
+       width = static_cast<double>(property.get_value());
+     }
+   }
+
+   Values are read from the object at the time they are asked for, so
+   a property that was deleted after the view was created reads as
+   undefined.
+   */
+  class JSPropertyView final {
+
+  public:
+
+    /*!
+     @class
+
+     @discussion A Property refers to one entry of a JSPropertyView. It
+     is only valid for as long as the JSPropertyView it came from.
+     */
+    class Property final {
+
+    public:
+
+      /*!
+       @method
+
+       @abstract Return the position of this property in enumeration
+       order.
+       */
+      std::size_t get_index() const HAL_NOEXCEPT {
+        return index__;
+      }
+
+      /*!
+       @method
+
+       @abstract Return the name of this property.
+       */
+      JSString get_name() const {
+        return JSString(JSPropertyNameArrayGetNameAtIndex(js_property_view__->js_property_name_array_ref__, index__));
+      }
+
+      /*!
+       @method
+
+       @abstract Return the value of this property.
+
+       @throws std::runtime_error if getting the property threw a
+       JavaScript exception.
+       */
+      JSValue get_value() const {
+        return js_property_view__->GetValue(JSPropertyNameArrayGetNameAtIndex(js_property_view__->js_property_name_array_ref__, index__));
+      }
+
+    private:
+
+      friend class JSPropertyView;
+
+      Property(const JSPropertyView* js_property_view, std::size_t index) HAL_NOEXCEPT
+      : js_property_view__(js_property_view)
+      , index__(index) {
+      }
+
+      const JSPropertyView* js_property_view__;
+      std::size_t           index__;
+    };
+
+    class const_iterator final {
+
+    public:
+
+      using iterator_category = std::input_iterator_tag;
+      using value_type        = Property;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = void;
+      using reference         = Property;
+
+      Property operator*() const HAL_NOEXCEPT {
+        return Property(js_property_view__, index__);
+      }
+
+      const_iterator& operator++() HAL_NOEXCEPT {
+        ++index__;
+        return *this;
+      }
+
+      const_iterator operator++(int) HAL_NOEXCEPT {
+        const_iterator previous(*this);
+        ++index__;
+        return previous;
+      }
+
+      bool operator==(const const_iterator& rhs) const HAL_NOEXCEPT {
+        return index__ == rhs.index__ && js_property_view__ == rhs.js_property_view__;
+      }
+
+      bool operator!=(const const_iterator& rhs) const HAL_NOEXCEPT {
+        return ! (*this == rhs);
+      }
+
+    private:
+
+      friend class JSPropertyView;
+
+      const_iterator(const JSPropertyView* js_property_view, std::size_t index) HAL_NOEXCEPT
+      : js_property_view__(js_property_view)
+      , index__(index) {
+      }
+
+      const JSPropertyView* js_property_view__;
+      std::size_t           index__;
+    };
+
+    /*!
+     @method
+
+     @abstract Create a view of the enumerable properties of a
+     JavaScript object.
+
+     @param js_object The JavaScript object to view. The view keeps
+     the object alive.
+     */
+    explicit JSPropertyView(const JSObject& js_object) HAL_NOEXCEPT
+    : js_object__(js_object)
+    , js_property_name_array_ref__(JSObjectCopyPropertyNames(static_cast<JSContextRef>(js_object.get_context()), static_cast<JSObjectRef>(js_object)))
+    , count__(JSPropertyNameArrayGetCount(js_property_name_array_ref__)) {
+    }
+
+    /*!
+     @method
+
+     @abstract Create a view of the enumerable properties of a
+     JavaScript object, taking over the given JSObject instead of
+     copying it.
+     */
+    explicit JSPropertyView(JSObject&& js_object) HAL_NOEXCEPT
+    : js_object__(std::move(js_object))
+    , js_property_name_array_ref__(JSObjectCopyPropertyNames(static_cast<JSContextRef>(js_object__.get_context()), static_cast<JSObjectRef>(js_object__)))
+    , count__(JSPropertyNameArrayGetCount(js_property_name_array_ref__)) {
+    }
+
+    std::size_t size() const HAL_NOEXCEPT {
+      return count__;
+    }
+
+    bool empty() const HAL_NOEXCEPT {
+      return count__ == 0;
+    }
+
+    const_iterator begin() const HAL_NOEXCEPT {
+      return const_iterator(this, 0);
+    }
+
+    const_iterator end() const HAL_NOEXCEPT {
+      return const_iterator(this, count__);
+    }
+
+    Property operator[](std::size_t index) const HAL_NOEXCEPT {
+      return Property(this, index);
+    }
+
+    ~JSPropertyView() HAL_NOEXCEPT {
+      if (js_property_name_array_ref__) {
+        JSPropertyNameArrayRelease(js_property_name_array_ref__);
+      }
+    }
+
+    JSPropertyView(const JSPropertyView& rhs) HAL_NOEXCEPT
+    : js_object__(rhs.js_object__)
+    , js_property_name_array_ref__(rhs.js_property_name_array_ref__ ? JSPropertyNameArrayRetain(rhs.js_property_name_array_ref__) : nullptr)
+    , count__(rhs.count__) {
+    }
+
+    JSPropertyView(JSPropertyView&& rhs) HAL_NOEXCEPT
+    : js_object__(std::move(rhs.js_object__))
+    , js_property_name_array_ref__(rhs.js_property_name_array_ref__)
+    , count__(rhs.count__) {
+      rhs.js_property_name_array_ref__ = nullptr;
+      rhs.count__                      = 0;
+    }
+
+    JSPropertyView& operator=(JSPropertyView rhs) HAL_NOEXCEPT {
+      swap(rhs);
+      return *this;
+    }
+
+    void swap(JSPropertyView& other) HAL_NOEXCEPT {
+      using std::swap;
+      swap(js_object__                 , other.js_object__);
+      swap(js_property_name_array_ref__, other.js_property_name_array_ref__);
+      swap(count__                     , other.count__);
+    }
+
+  private:
+
+    JSValue GetValue(JSStringRef property_name_ref) const {
+      const auto js_context = js_object__.get_context();
+      JSValueRef exception { nullptr };
+      JSValueRef js_value_ref = JSObjectGetProperty(static_cast<JSContextRef>(js_context), static_cast<JSObjectRef>(js_object__), property_name_ref, &exception);
+      if (exception) {
+        detail::ThrowRuntimeError("JSPropertyView", JSValue(js_context, exception));
+      }
+      return JSValue(js_context, js_value_ref);
+    }
+
+    JSObject               js_object__;
+    JSPropertyNameArrayRef js_property_name_array_ref__;
+    std::size_t            count__;
+  };
+
+  inline
+  void swap(JSPropertyView& first, JSPropertyView& second) HAL_NOEXCEPT {
+    first.swap(second);
+  }
+
+  inline
+  JSPropertyView JSObject::GetPropertyView() const HAL_NOEXCEPT {
+    return JSPropertyView(*this);
+  }
+
+  template<typename Callback>
+  void JSObject::ForEachProperty(Callback&& callback) const {
+    const JSPropertyView js_property_view(*this);
+    for (const auto property : js_property_view) {
+      callback(property.get_name(), property.get_value());
+    }
+  }
+
+} // namespace HAL {
+
+#endif // _HAL_JSPROPERTYVIEW_HPP_
@@ -0,0 +1,251 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSREFLECT_HPP_
+#define _HAL_JSREFLECT_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSValue.hpp"
+#include "HAL/detail/JSValueConverter.hpp"
+#include "HAL/detail/JSStringRefHolder.hpp"
+
+#include <string>
+#include <vector>
+#include <cctype>
+#include <type_traits>
+
+/*!
+ @define
+ 
+ @abstract Describe the fields of a C++ struct so that it can be
+ converted to and from a JavaScript object with HAL::ToJS and
+ HAL::FromJS.
+ 
+ @discussion HAL_REFLECT must be used in the namespace that declares
+ the struct, after its definition, and names up to 16 public data
+ members. Each member must itself be convertible: bool, an arithmetic
+ type, std::string, JSValue, JSObject, a std::vector of a convertible
+ type, or another struct described by HAL_REFLECT.
+ 
+ For example:
+ 
+ struct Point {
+   double x;
+   double y;
+ };
+ 
+ HAL_REFLECT(Point, x, y)
+ 
+ JSValue js_point = ToJS(js_context, Point { 1, 2 });
+ Point   point    = FromJS<Point>(js_point);
+ 
+ The field list is expanded at compile time, and the JavaScript
+ property names are interned once per type on first use, so
+ converting a struct performs no string hashing or per-field memory
+ allocation on the C++ side.
+ */
+#define HAL_REFLECT(TYPE, ...)                                                  \
+  inline const char* HAL_reflect_field_names(const TYPE*) HAL_NOEXCEPT {        \
+    return #__VA_ARGS__;                                                        \
+  }                                                                             \
+  template<typename Visitor>                                                    \
+  inline void HAL_reflect_visit_fields(TYPE& object, Visitor& visitor) {        \
+    HAL_REFLECT_FOR_EACH(HAL_REFLECT_VISIT_FIELD, __VA_ARGS__)                  \
+  }                                                                             \
+  template<typename Visitor>                                                    \
+  inline void HAL_reflect_visit_fields(const TYPE& object, Visitor& visitor) {  \
+    HAL_REFLECT_FOR_EACH(HAL_REFLECT_VISIT_FIELD, __VA_ARGS__)                  \
+  }
+
+#define HAL_REFLECT_VISIT_FIELD(field) visitor(object.field);
+
+#define HAL_REFLECT_EXPAND(x) x
+#define HAL_REFLECT_FOR_EACH_1(M, a) M(a)
+#define HAL_REFLECT_FOR_EACH_2(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_1(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_3(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_2(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_4(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_3(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_5(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_4(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_6(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_5(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_7(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_6(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_8(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_7(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_9(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_8(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_10(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_9(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_11(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_10(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_12(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_11(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_13(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_12(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_14(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_13(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_15(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_14(M, __VA_ARGS__))
+#define HAL_REFLECT_FOR_EACH_16(M, a, ...) M(a) HAL_REFLECT_EXPAND(HAL_REFLECT_FOR_EACH_15(M, __VA_ARGS__))
+#define HAL_REFLECT_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, NAME, ...) NAME
+#define HAL_REFLECT_FOR_EACH(M, ...) HAL_REFLECT_EXPAND(HAL_REFLECT_SELECT(__VA_ARGS__, HAL_REFLECT_FOR_EACH_16, HAL_REFLECT_FOR_EACH_15, HAL_REFLECT_FOR_EACH_14, HAL_REFLECT_FOR_EACH_13, HAL_REFLECT_FOR_EACH_12, HAL_REFLECT_FOR_EACH_11, HAL_REFLECT_FOR_EACH_10, HAL_REFLECT_FOR_EACH_9, HAL_REFLECT_FOR_EACH_8, HAL_REFLECT_FOR_EACH_7, HAL_REFLECT_FOR_EACH_6, HAL_REFLECT_FOR_EACH_5, HAL_REFLECT_FOR_EACH_4, HAL_REFLECT_FOR_EACH_3, HAL_REFLECT_FOR_EACH_2, HAL_REFLECT_FOR_EACH_1)(M, __VA_ARGS__))
+
+namespace HAL { namespace detail {
+  
+  // True if HAL_REFLECT has been used to describe T.
+  template<typename T>
+  struct is_js_reflected {
+  private:
+    template<typename U>
+    static auto test(int) -> decltype(HAL_reflect_field_names(static_cast<const U*>(nullptr)), std::true_type());
+    
+    template<typename U>
+    static std::false_type test(...);
+    
+  public:
+    static const bool value = decltype(test<T>(0))::value;
+  };
+  
+  /*!
+   @class
+   
+   @discussion JSReflectFieldNames holds the interned JavaScript
+   property names of a struct described by HAL_REFLECT, in declaration
+   order. The names are created once, the first time the type is
+   converted.
+   */
+  template<typename T>
+  class JSReflectFieldNames final {
+    
+  public:
+    
+    static const JSStringRefHolder* Get() {
+      static const std::vector<JSStringRefHolder> names = Parse(HAL_reflect_field_names(static_cast<const T*>(nullptr)));
+      return names.data();
+    }
+    
+  private:
+    
+    // Split the stringized field list "x, y" into its names.
+    static std::vector<JSStringRefHolder> Parse(const std::string& field_list) {
+      std::vector<JSStringRefHolder> names;
+      std::string name;
+      for (const char c : field_list) {
+        if (c == ',') {
+          names.emplace_back(JSStringCreateWithUTF8CString(name.c_str()));
+          name.clear();
+        } else if (!std::isspace(static_cast<unsigned char>(c))) {
+          name.push_back(c);
+        }
+      }
+      names.emplace_back(JSStringCreateWithUTF8CString(name.c_str()));
+      return names;
+    }
+  };
+  
+  struct JSReflectToJSVisitor final {
+    
+    template<typename F>
+    void operator()(const F& field) {
+      JSValueRef exception { nullptr };
+      JSObjectSetProperty(js_context_ref, js_object_ref, (name++)->js_string_ref__, JSValueConverter<F>::ToJSValueRef(js_context_ref, field), kJSPropertyAttributeNone, &exception);
+      ThrowIfJSException(js_context_ref, exception, "ToJS");
+    }
+    
+    JSContextRef             js_context_ref;
+    JSObjectRef              js_object_ref;
+    const JSStringRefHolder* name;
+  };
+  
+  // Properties that are undefined leave the corresponding field at its
+  // default value.
+  struct JSReflectFromJSVisitor final {
+    
+    template<typename F>
+    void operator()(F& field) {
+      JSValueRef exception { nullptr };
+      JSValueRef js_value_ref = JSObjectGetProperty(js_context_ref, js_object_ref, (name++)->js_string_ref__, &exception);
+      ThrowIfJSException(js_context_ref, exception, "FromJS");
+      if (!JSValueIsUndefined(js_context_ref, js_value_ref)) {
+        field = JSValueConverter<F>::FromJSValueRef(js_context_ref, js_value_ref);
+      }
+    }
+    
+    JSContextRef             js_context_ref;
+    JSObjectRef              js_object_ref;
+    const JSStringRefHolder* name;
+  };
+  
+  // A struct described by HAL_REFLECT converts to and from a plain
+  // JavaScript object with one property per field.
+  template<typename T>
+  struct JSValueConverter<T, typename std::enable_if<is_js_reflected<T>::value>::type> {
+    
+    static JSValueRef ToJSValueRef(JSContextRef js_context_ref, const T& object) {
+      JSObjectRef js_object_ref = JSObjectMake(js_context_ref, nullptr, nullptr);
+      JSReflectToJSVisitor visitor { js_context_ref, js_object_ref, JSReflectFieldNames<T>::Get() };
+      HAL_reflect_visit_fields(object, visitor);
+      return js_object_ref;
+    }
+    
+    static T FromJSValueRef(JSContextRef js_context_ref, JSValueRef js_value_ref) {
+      JSValueRef exception { nullptr };
+      JSObjectRef js_object_ref = JSValueToObject(js_context_ref, js_value_ref, &exception);
+      ThrowIfJSException(js_context_ref, exception, "FromJS");
+      T object {};
+      JSReflectFromJSVisitor visitor { js_context_ref, js_object_ref, JSReflectFieldNames<T>::Get() };
+      HAL_reflect_visit_fields(object, visitor);
+      return object;
+    }
+  };
+  
+} // namespace detail {
+  
+  /*!
+   @function
+   
+   @abstract Convert a C++ value to a JavaScript value.
+   
+   @discussion T may be any type supported by
+   detail::JSValueConverter, including structs described by
+   HAL_REFLECT and std::vectors of them. A std::vector is converted to
+   a JavaScript array in a single pass.
+   
+   @param js_context The execution context to use.
+   
+   @param value The C++ value to convert.
+   
+   @result The JavaScript value.
+   
+   @throws std::runtime_error if a JavaScript exception was thrown
+   during the conversion.
+   */
+  template<typename T>
+  JSValue ToJS(const JSContext& js_context, const T& value) {
+    using Converter = detail::JSValueConverter<JSValue>;
+    JSContextRef js_context_ref = Converter::ToJSContextRef(js_context);
+    return Converter::ToJSValue(js_context_ref, detail::JSValueConverter<T>::ToJSValueRef(js_context_ref, value));
+  }
+  
+  /*!
+   @function
+   
+   @abstract Convert a JavaScript value to a C++ value.
+   
+   @discussion T may be any type supported by
+   detail::JSValueConverter, including structs described by
+   HAL_REFLECT and std::vectors of them. Properties that are undefined
+   leave the corresponding struct field value initialized.
+   
+   @param js_value The JavaScript value to convert.
+   
+   @result The C++ value.
+   
+   @throws std::runtime_error if a JavaScript exception was thrown
+   during the conversion.
+   */
+  template<typename T>
+  T FromJS(const JSValue& js_value) {
+    using Converter = detail::JSValueConverter<JSValue>;
+    JSContextRef js_context_ref = Converter::ToJSContextRef(js_value.get_context());
+    return detail::JSValueConverter<T>::FromJSValueRef(js_context_ref, Converter::ToJSValueRef(js_context_ref, js_value));
+  }
+  
+} // namespace HAL {
+
+#endif // _HAL_JSREFLECT_HPP_
@@ -0,0 +1,450 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSRESULT_HPP_
+#define _HAL_JSRESULT_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSString.hpp"
+#include "HAL/JSValue.hpp"
+#include "HAL/JSObject.hpp"
+#include "HAL/detail/JSUtil.hpp"
+
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSNativeError is the error of a failed JSResult. It is
+   either an exception thrown by JavaScript, which is kept as is, or an
+   error reported by native code, which is kept as a message.
+
+   Nothing is allocated in JavaScript for an error reported by native
+   code until get_value() is called, for example to throw it into
+   script. Native code that handles the error itself, such as a
+   validation failure that is retried or reported differently, never
+   pays for the JavaScript Error object.
+
+   A JSNativeError is not thread safe: get_value() creates the Error
+   object the first time it is called.
+   */
+  class JSNativeError final {
+
+  public:
+
+    /*!
+     @method
+
+     @abstract Create an error reported by native code.
+
+     @param js_context The execution context in which the JavaScript
+     Error object is created if it is ever needed.
+
+     @param internal_component_name The name of the component that
+     reported the error, as passed to detail::ThrowRuntimeError.
+
+     @param message The error's message.
+     */
+    JSNativeError(const JSContext& js_context, std::string internal_component_name, std::string message)
+    : js_global_context_ref__(JSGlobalContextRetain(JSContextGetGlobalContext(static_cast<JSContextRef>(js_context))))
+    , internal_component_name__(std::move(internal_component_name))
+    , message__(std::move(message)) {
+    }
+
+    /*!
+     @method
+
+     @abstract Return whether this error is an exception thrown by
+     JavaScript, as opposed to an error reported by native code.
+     */
+    bool IsJSException() const HAL_NOEXCEPT {
+      return is_js_exception__;
+    }
+
+    std::string get_internal_component_name() const {
+      return internal_component_name__;
+    }
+
+    /*!
+     @method
+
+     @abstract Return the error's message. For an exception thrown by
+     JavaScript this is the exception converted to a string.
+     */
+    std::string get_message() const {
+      if (is_js_exception__) {
+        return static_cast<std::string>(get_value());
+      }
+      return message__;
+    }
+
+    /*!
+     @method
+
+     @abstract Return the error as a JavaScript value, creating a
+     JavaScript Error object for an error reported by native code the
+     first time this is called.
+     */
+    JSValue get_value() const HAL_NOEXCEPT {
+      if (js_value_ref__ == nullptr) {
+        JSStringRef message_ref = JSStringCreateWithUTF8CString(message__.c_str());
+        JSValueRef  argument    = JSValueMakeString(js_global_context_ref__, message_ref);
+        JSStringRelease(message_ref);
+        js_value_ref__ = JSObjectMakeError(js_global_context_ref__, 1, &argument, nullptr);
+        JSValueProtect(js_global_context_ref__, js_value_ref__);
+      }
+      return JSValue(JSContext(js_global_context_ref__), js_value_ref__);
+    }
+
+    /*!
+     @method
+
+     @abstract Throw this error as a C++ exception, the same way the
+     throwing API would have.
+
+     @throws std::runtime_error
+     */
+    void Throw() const {
+      if (is_js_exception__) {
+        detail::ThrowRuntimeError(internal_component_name__, get_value());
+      }
+      detail::ThrowRuntimeError(internal_component_name__, message__);
+    }
+
+    ~JSNativeError() HAL_NOEXCEPT {
+      if (js_value_ref__) {
+        JSValueUnprotect(js_global_context_ref__, js_value_ref__);
+      }
+      JSGlobalContextRelease(js_global_context_ref__);
+    }
+
+    JSNativeError(const JSNativeError& rhs)
+    : js_global_context_ref__(JSGlobalContextRetain(rhs.js_global_context_ref__))
+    , js_value_ref__(rhs.js_value_ref__)
+    , is_js_exception__(rhs.is_js_exception__)
+    , internal_component_name__(rhs.internal_component_name__)
+    , message__(rhs.message__) {
+      if (js_value_ref__) {
+        JSValueProtect(js_global_context_ref__, js_value_ref__);
+      }
+    }
+
+    JSNativeError(JSNativeError&& rhs) HAL_NOEXCEPT
+    : js_global_context_ref__(JSGlobalContextRetain(rhs.js_global_context_ref__))
+    , js_value_ref__(rhs.js_value_ref__)
+    , is_js_exception__(rhs.is_js_exception__)
+    , internal_component_name__(std::move(rhs.internal_component_name__))
+    , message__(std::move(rhs.message__)) {
+      rhs.js_value_ref__ = nullptr;
+    }
+
+    JSNativeError& operator=(JSNativeError rhs) HAL_NOEXCEPT {
+      swap(rhs);
+      return *this;
+    }
+
+    void swap(JSNativeError& other) HAL_NOEXCEPT {
+      using std::swap;
+      swap(js_global_context_ref__   , other.js_global_context_ref__);
+      swap(js_value_ref__            , other.js_value_ref__);
+      swap(is_js_exception__         , other.is_js_exception__);
+      swap(internal_component_name__ , other.internal_component_name__);
+      swap(message__                 , other.message__);
+    }
+
+  private:
+
+    // JSObject and JSContext create a JSNativeError from the exception
+    // reported by the JavaScriptCore C API.
+    friend class JSObject;
+    friend class JSContext;
+
+    JSNativeError(JSContextRef js_context_ref, const char* internal_component_name, JSValueRef exception_ref)
+    : js_global_context_ref__(JSGlobalContextRetain(JSContextGetGlobalContext(js_context_ref)))
+    , js_value_ref__(exception_ref)
+    , is_js_exception__(true)
+    , internal_component_name__(internal_component_name) {
+      JSValueProtect(js_global_context_ref__, js_value_ref__);
+    }
+
+    JSGlobalContextRef js_global_context_ref__;
+    mutable JSValueRef js_value_ref__ { nullptr };
+    bool               is_js_exception__ { false };
+    std::string        internal_component_name__;
+    std::string        message__;
+  };
+
+  inline
+  void swap(JSNativeError& first, JSNativeError& second) HAL_NOEXCEPT {
+    first.swap(second);
+  }
+
+  /*!
+   @class
+
+   @discussion A JSResult holds either a value of type T or the
+   JSNativeError that prevented producing it. The Try counterparts of
+   the throwing API, such as JSObject::TryGetProperty,
+   JSObject::TryCallAsFunction and JSContext::TryEvaluateScript,
+   return a JSResult so that a failure costs a branch instead of a C++
+   exception. They still allocate, so std::bad_alloc is the one
+   exception they can throw:
+
+   auto result = js_object.TryGetProperty("width");
+   if (!result) {
+     // result.error() describes the failure.
+   }
+   */
+  template<typename T>
+  class JSResult final {
+
+  public:
+
+    JSResult(const T& value)
+    : has_value__(true) {
+      ::new (static_cast<void*>(&value__)) T(value);
+    }
+
+    JSResult(T&& value) HAL_NOEXCEPT
+    : has_value__(true) {
+      ::new (static_cast<void*>(&value__)) T(std::move(value));
+    }
+
+    JSResult(const JSNativeError& error)
+    : has_value__(false) {
+      ::new (static_cast<void*>(&error__)) JSNativeError(error);
+    }
+
+    JSResult(JSNativeError&& error) HAL_NOEXCEPT
+    : has_value__(false) {
+      ::new (static_cast<void*>(&error__)) JSNativeError(std::move(error));
+    }
+
+    /*!
+     @method
+
+     @abstract Return true if this JSResult holds a value.
+     */
+    bool has_value() const HAL_NOEXCEPT {
+      return has_value__;
+    }
+
+    explicit operator bool() const HAL_NOEXCEPT {
+      return has_value__;
+    }
+
+    /*!
+     @method
+
+     @abstract Return the value.
+
+     @throws std::runtime_error if this JSResult holds an error, as the
+     throwing API would have.
+     */
+    const T& value() const & {
+      if (!has_value__) {
+        error__.Throw();
+      }
+      return value__;
+    }
+
+    T value() && {
+      if (!has_value__) {
+        error__.Throw();
+      }
+      return std::move(value__);
+    }
+
+    /*!
+     @method
+
+     @abstract Return the value, or the given default value if this
+     JSResult holds an error.
+     */
+    T value_or(const T& default_value) const {
+      return has_value__ ? value__ : default_value;
+    }
+
+    /*!
+     @method
+
+     @abstract Return the error. This must only be called if this
+     JSResult doesn't hold a value.
+     */
+    const JSNativeError& error() const HAL_NOEXCEPT {
+      return error__;
+    }
+
+    ~JSResult() HAL_NOEXCEPT {
+      Destroy();
+    }
+
+    JSResult(const JSResult& rhs)
+    : has_value__(rhs.has_value__) {
+      if (has_value__) {
+        ::new (static_cast<void*>(&value__)) T(rhs.value__);
+      } else {
+        ::new (static_cast<void*>(&error__)) JSNativeError(rhs.error__);
+      }
+    }
+
+    JSResult(JSResult&& rhs) HAL_NOEXCEPT
+    : has_value__(rhs.has_value__) {
+      if (has_value__) {
+        ::new (static_cast<void*>(&value__)) T(std::move(rhs.value__));
+      } else {
+        ::new (static_cast<void*>(&error__)) JSNativeError(std::move(rhs.error__));
+      }
+    }
+
+    JSResult& operator=(const JSResult& rhs) {
+      // Copy first so that this JSResult is unchanged if the copy
+      // throws.
+      JSResult copy(rhs);
+      return *this = std::move(copy);
+    }
+
+    JSResult& operator=(JSResult&& rhs) HAL_NOEXCEPT {
+      if (this != &rhs) {
+        Destroy();
+        ::new (static_cast<void*>(this)) JSResult(std::move(rhs));
+      }
+      return *this;
+    }
+
+  private:
+
+    void Destroy() HAL_NOEXCEPT {
+      if (has_value__) {
+        value__.~T();
+      } else {
+        error__.~JSNativeError();
+      }
+    }
+
+    union {
+      T             value__;
+      JSNativeError error__;
+    };
+
+    bool has_value__;
+  };
+
+  inline
+  JSResult<JSValue> JSObject::TryGetProperty(const JSString& property_name) const {
+    const auto js_context_ref = static_cast<JSContextRef>(js_context__);
+    JSValueRef exception { nullptr };
+    JSValueRef js_value_ref = JSObjectGetProperty(js_context_ref, js_object_ref__, static_cast<JSStringRef>(property_name), &exception);
+    if (exception) {
+      return JSNativeError(js_context_ref, "JSObject", exception);
+    }
+    return JSValue(js_context__, js_value_ref);
+  }
+
+  inline
+  JSResult<JSValue> JSObject::TryCallAsFunction(const std::vector<JSValue>& arguments, const JSObject& this_object) const {
+    const auto js_context_ref = static_cast<JSContextRef>(js_context__);
+    if (!JSObjectIsFunction(js_context_ref, js_object_ref__)) {
+      return JSNativeError(js_context__, "JSObject", "This JavaScript object can not be called as a function.");
+    }
+
+    std::vector<JSValueRef> arguments_array;
+    arguments_array.reserve(arguments.size());
+    for (const auto& argument : arguments) {
+      arguments_array.push_back(static_cast<JSValueRef>(argument));
+    }
+
+    JSValueRef exception { nullptr };
+    JSValueRef js_value_ref = JSObjectCallAsFunction(js_context_ref, js_object_ref__, this_object.js_object_ref__, arguments_array.size(), arguments_array.data(), &exception);
+    if (exception) {
+      return JSNativeError(js_context_ref, "JSObject", exception);
+    }
+    return JSValue(js_context__, js_value_ref);
+  }
+
+  inline
+  JSResult<JSValue> JSObject::TryCallAsFunction(const std::vector<JSValue>& arguments) const {
+    return TryCallAsFunction(arguments, get_context().get_global_object());
+  }
+
+  inline
+  JSResult<JSValue> JSContext::TryEvaluateScript(const JSString& script, const JSObject& this_object, const JSString& source_url, int starting_line_number) const {
+    const auto source_url_ref = static_cast<JSStringRef>(source_url);
+    JSValueRef exception { nullptr };
+    JSValueRef js_value_ref = ::JSEvaluateScript(js_global_context_ref__, static_cast<JSStringRef>(script), static_cast<JSObjectRef>(this_object), JSStringGetLength(source_url_ref) > 0 ? source_url_ref : nullptr, starting_line_number, &exception);
+    if (exception) {
+      return JSNativeError(js_global_context_ref__, "JSContext", exception);
+    }
+    return JSValue(*this, js_value_ref);
+  }
+
+  inline
+  JSResult<JSValue> JSContext::TryEvaluateScript(const JSString& script) const {
+    return TryEvaluateScript(script, get_global_object(), JSString());
+  }
+
+  inline
+  JSResult<JSValue> JSContext::TryEvaluateScript(const JSString& script, const JSObject& this_object) const {
+    return TryEvaluateScript(script, this_object, JSString());
+  }
+
+  inline
+  JSResult<JSValue> JSContext::TryEvaluateScript(const JSString& script, const JSString& source_url, int starting_line_number) const {
+    return TryEvaluateScript(script, get_global_object(), source_url, starting_line_number);
+  }
+
+  template<typename U, typename>
+  JSValue JSObject::operator()(const U& this_object) {
+    return TryCallAsFunction(std::vector<JSValue>(), this_object).value();
+  }
+
+  template<typename U, typename>
+  JSValue JSObject::operator()(JSValue& argument, const U& this_object) {
+    return TryCallAsFunction(std::vector<JSValue>{argument}, this_object).value();
+  }
+
+  template<typename U, typename>
+  JSValue JSObject::operator()(const JSString& argument, const U& this_object) {
+    return TryCallAsFunction(std::vector<JSValue>{get_context().CreateString(argument)}, this_object).value();
+  }
+
+  template<typename U, typename>
+  JSValue JSObject::operator()(const std::vector<JSValue>& arguments, const U& this_object) {
+    return TryCallAsFunction(arguments, this_object).value();
+  }
+
+  template<typename U, typename>
+  JSValue JSObject::operator()(const std::vector<JSString>& arguments, const U& this_object) {
+    const auto js_context = get_context();
+    std::vector<JSValue> js_value_arguments;
+    js_value_arguments.reserve(arguments.size());
+    for (const auto& argument : arguments) {
+      js_value_arguments.push_back(js_context.CreateString(argument));
+    }
+    return TryCallAsFunction(js_value_arguments, this_object).value();
+  }
+
+  template<typename U, typename>
+  JSValue JSContext::JSEvaluateScript(const JSString& script, const U& this_object) const {
+    return TryEvaluateScript(script, this_object, JSString()).value();
+  }
+
+  template<typename U, typename>
+  JSValue JSContext::JSEvaluateScript(const JSString& script, const U& this_object, const JSString& source_url, int starting_line_number) const {
+    return TryEvaluateScript(script, this_object, source_url, starting_line_number).value();
+  }
+
+} // namespace HAL {
+
+#endif // _HAL_JSRESULT_HPP_
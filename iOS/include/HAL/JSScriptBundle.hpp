@@ -0,0 +1,256 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSSCRIPTBUNDLE_HPP_
+#define _HAL_JSSCRIPTBUNDLE_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSString.hpp"
+#include "HAL/JSValue.hpp"
+#include "HAL/detail/JSScriptBundleFormat.hpp"
+#include "HAL/detail/JSStringRefHolder.hpp"
+#include "HAL/detail/JSUtil.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#include <memory>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSScriptBundle maps a bundle of scripts written by the
+   JSScriptBundlePacker tool, such as App/app.js and everything it
+   requires, into memory with a single mmap. The packer checked every
+   script's syntax, and stored it as UTF-16, so Evaluate hands
+   JavaScriptCore the mapped source instead of reading and converting
+   a file. With HAL_PRIVATE_API_ENABLE JavaScriptCore refers to the
+   mapping itself; otherwise it makes one copy of the source.
+
+   For example:
+
+   JSScriptBundle bundle("App.jsbundle");
+   bundle.Evaluate(js_context, "/app.js");
+
+   With HAL_PRIVATE_API_ENABLE JavaScriptCore keeps referring to a
+   script's source for as long as any function defined by it is alive,
+   so the bundle must outlive every context that a script from it was
+   evaluated in. Most
+   applications open their bundle once and never close it.
+
+   A JSScriptBundle is immutable once opened, so it may be used on any
+   thread.
+   */
+  class JSScriptBundle final HAL_PERFORMANCE_COUNTER1(JSScriptBundle) {
+
+  public:
+
+    /*!
+     @method
+
+     @abstract Map the bundle at the given path into memory.
+
+     @throws std::runtime_error if the file can't be read or isn't a
+     well formed bundle.
+     */
+    explicit JSScriptBundle(const std::string& path) {
+      Map(path);
+      const std::string error = detail::ValidateJSScriptBundle(data__, size__);
+      if (!error.empty()) {
+        Unmap();
+        detail::ThrowRuntimeError("JSScriptBundle", path + ": " + error);
+      }
+      const auto header = reinterpret_cast<const detail::JSScriptBundleHeader*>(data__);
+      entries__      = reinterpret_cast<const detail::JSScriptBundleEntry*>(data__ + header -> index_offset);
+      script_count__ = header -> script_count;
+    }
+
+    ~JSScriptBundle() HAL_NOEXCEPT {
+      Unmap();
+    }
+
+    /*!
+     @method
+
+     @abstract Return whether the bundle has a script with the given
+     name, such as "/app.js".
+     */
+    bool Contains(const std::string& name) const HAL_NOEXCEPT {
+      return Find(name) != nullptr;
+    }
+
+    /*!
+     @method
+
+     @abstract Return the source of the script with the given name.
+
+     @discussion JSString caches UTF-8 and UTF-16 copies of the
+     source. Use Evaluate to evaluate a script without them.
+
+     @throws std::runtime_error if the bundle has no script with the
+     given name.
+     */
+    JSString GetScript(const std::string& name) const {
+      detail::JSStringRefHolder script(CreateScriptRef(name));
+      return JSString(script.js_string_ref__);
+    }
+
+    /*!
+     @method
+
+     @abstract Evaluate the script with the given name in the given
+     context, using its name as its source URL.
+
+     @discussion The script is passed to JavaScriptCore as a view into
+     the mapped bundle if HAL_PRIVATE_API_ENABLE allows it, and
+     otherwise copied once.
+
+     @throws std::runtime_error if the bundle has no script with the
+     given name, or the script threw an exception.
+     */
+    JSValue Evaluate(const JSContext& js_context, const std::string& name) const {
+      detail::JSStringRefHolder script(CreateScriptRef(name));
+      detail::JSStringRefHolder source_url(JSStringCreateWithUTF8CString(name.c_str()));
+      JSValueRef exception { nullptr };
+      JSValueRef js_value_ref = ::JSEvaluateScript(static_cast<JSContextRef>(js_context), script.js_string_ref__, nullptr, source_url.js_string_ref__, 1, &exception);
+      if (exception) {
+        detail::ThrowRuntimeError("JSScriptBundle", JSValue(js_context, exception), name, 1);
+      }
+      return JSValue(js_context, js_value_ref);
+    }
+
+    // Return the names of the bundle's scripts, in order.
+    std::vector<std::string> GetNames() const {
+      std::vector<std::string> names;
+      names.reserve(script_count__);
+      for (std::size_t i = 0; i < script_count__; ++i) {
+        names.emplace_back(data__ + entries__[i].name_offset, static_cast<std::size_t>(entries__[i].name_size));
+      }
+      return names;
+    }
+
+    std::size_t get_script_count() const HAL_NOEXCEPT {
+      return script_count__;
+    }
+
+    std::size_t get_size() const HAL_NOEXCEPT {
+      return size__;
+    }
+
+    JSScriptBundle(const JSScriptBundle&)            = delete;
+    JSScriptBundle& operator=(const JSScriptBundle&) = delete;
+
+  private:
+
+    // JSModuleLoader reads modules through CreateScriptRef.
+    friend class JSModuleLoader;
+
+    // Create a JSStringRef referring to the source of the script with
+    // the given name in the mapped bundle.
+    JSStringRef CreateScriptRef(const std::string& name) const {
+      const auto entry = Find(name);
+      if (entry == nullptr) {
+        detail::ThrowRuntimeError("JSScriptBundle", "no script named " + name);
+      }
+      const auto characters = reinterpret_cast<const JSChar*>(data__ + entry -> source_offset);
+      return detail::CreateJSStringRefNoCopy(characters, static_cast<std::size_t>(entry -> source_length));
+    }
+
+    // The index is sorted by name.
+    const detail::JSScriptBundleEntry* Find(const std::string& name) const HAL_NOEXCEPT {
+      std::size_t first = 0;
+      std::size_t last  = script_count__;
+      while (first < last) {
+        const std::size_t middle = first + (last - first) / 2;
+        const int result = detail::CompareJSScriptBundleName(data__, entries__[middle], name.data(), name.size());
+        if (result == 0) {
+          return &entries__[middle];
+        }
+        if (result < 0) {
+          first = middle + 1;
+        } else {
+          last = middle;
+        }
+      }
+      return nullptr;
+    }
+
+#ifdef _WIN32
+    // Read the whole bundle at once instead.
+    void Map(const std::string& path) {
+      std::ifstream file(path, std::ios::binary | std::ios::ate);
+      if (!file) {
+        detail::ThrowRuntimeError("JSScriptBundle", "can't open " + path);
+      }
+      size__ = static_cast<std::size_t>(file.tellg());
+      buffer__.reset(new char[size__]);
+      file.seekg(0);
+      if (!file.read(buffer__.get(), size__)) {
+        detail::ThrowRuntimeError("JSScriptBundle", "can't read " + path);
+      }
+      data__ = buffer__.get();
+    }
+
+    void Unmap() HAL_NOEXCEPT {
+      buffer__.reset();
+      data__ = nullptr;
+    }
+
+    std::unique_ptr<char[]> buffer__;
+#else
+    void Map(const std::string& path) {
+      const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+        detail::ThrowRuntimeError("JSScriptBundle", "can't open " + path);
+      }
+      struct stat status;
+      if (::fstat(fd, &status) != 0 || status.st_size <= 0) {
+        ::close(fd);
+        detail::ThrowRuntimeError("JSScriptBundle", "can't read " + path);
+      }
+      size__ = static_cast<std::size_t>(status.st_size);
+      void* data = ::mmap(nullptr, size__, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (data == MAP_FAILED) {
+        detail::ThrowRuntimeError("JSScriptBundle", "can't map " + path);
+      }
+      // The application's scripts are about to be read, so start
+      // paging them in now.
+      ::madvise(data, size__, MADV_WILLNEED);
+      data__ = static_cast<const char*>(data);
+    }
+
+    void Unmap() HAL_NOEXCEPT {
+      if (data__) {
+        ::munmap(const_cast<char*>(data__), size__);
+        data__ = nullptr;
+      }
+    }
+#endif
+
+    const char*                        data__         { nullptr };
+    std::size_t                        size__         { 0 };
+    const detail::JSScriptBundleEntry* entries__      { nullptr };
+    std::size_t                        script_count__ { 0 };
+  };
+
+} // namespace HAL {
+
+#endif // _HAL_JSSCRIPTBUNDLE_HPP_
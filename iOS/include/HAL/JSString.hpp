@@ -17,8 +17,16 @@
 #include <cstddef>
 #include <vector>
 #include <utility>
+#include <cstring>
 #include <mutex>
 
+#ifdef HAL_STRING_VIEW_ENABLE
+#include <string_view>
+#endif
+
+#include "HAL/detail/JSStringRefHolder.hpp"
+#include "HAL/detail/JSStringTranscoder.hpp"
+
 namespace HAL {
   class JSString;
 }
@@ -28,6 +36,12 @@ namespace HAL { namespace detail {
   class JSExportClass;
   
   HAL_EXPORT std::vector<JSStringRef> to_vector(const std::vector<JSString>&);
+  
+  struct JSStringLiteral;
+  class JSStringUnits;
+  
+  template<typename T, typename Enable>
+  struct JSValueConverter;
 }}
 
 namespace HAL {
@@ -45,6 +59,12 @@ namespace HAL {
    Specifically, a JSString is comparable with an equivalence relation,
    provides a strict weak ordering, and provides a custom hash
    function.
+   
+   JSStrings are ordered by comparing their UTF-16 code units, which
+   doesn't allocate. Use JSStringHash and JSStringEqualTo to look up a
+   JSString-keyed std::unordered_map with a std::string_view or a
+   JSStringRef without creating a JSString, and JSStringLess to do the
+   same for a std::map.
    */
     class HAL_EXPORT JSString final HAL_PERFORMANCE_COUNTER1(JSString) {
       
@@ -85,6 +105,48 @@ namespace HAL {
        */
       JSString(const std::string& string) HAL_NOEXCEPT;
       
+      /*!
+       @method
+       
+       @abstract Create a JavaScript string from UTF-16 code units.
+       
+       @param characters The UTF-16 code units to copy into the new
+       JSString.
+       
+       @param length The number of code units in characters.
+       
+       @result A JSString containing characters.
+       */
+      JSString(const char16_t* characters, std::size_t length);
+      
+#ifdef HAL_STRING_VIEW_ENABLE
+      /*!
+       @method
+       
+       @abstract Create a JavaScript string from a UTF8 string view,
+       which need not be null-terminated.
+       
+       @discussion The string is transcoded directly into the new
+       JSString without an intermediate std::string.
+       
+       @param string The UTF8 string to copy into the new JSString.
+       
+       @result A JSString containing string.
+       */
+      JSString(std::string_view string);
+      
+      /*!
+       @method
+       
+       @abstract Create a JavaScript string from a UTF-16 string view.
+       
+       @param string The UTF-16 string to copy into the new JSString.
+       
+       @result A JSString containing string.
+       */
+      JSString(std::u16string_view string);
+#endif
+      
       /*!
        @method
        
@@ -166,13 +228,34 @@ namespace HAL {
       
       // Only the following classes and functions can create a JSString.
       friend class JSValue;
+      friend class JSPropertyView; // property names
       
       template<typename T>
       friend class detail::JSExportClass; // static functions
       
+      friend struct detail::JSStringLiteral; // operator"" _js
+      friend class  detail::JSStringUnits;   // ordering and hashing
+      friend class  JSScriptBundle;          // mapped sources
+      
+      template<typename T, typename Enable>
+      friend struct detail::JSValueConverter; // JavaScript strings
+      
       // For interoperability with the JavaScriptCore C API.
       explicit JSString(JSStringRef js_string_ref) HAL_NOEXCEPT;
       
+      // Return a new JSStringRef, which the caller must release,
+      // containing UTF8 data of the given length.
+      static JSStringRef CreateJSStringRef(const char* data, std::size_t length) {
+        JSChar buffer[256];
+        std::vector<JSChar> heap_buffer;
+        JSChar* characters = buffer;
+        if (length > sizeof(buffer) / sizeof(buffer[0])) {
+          heap_buffer.resize(length);
+          characters = heap_buffer.data();
+        }
+        return JSStringCreateWithCharacters(characters, detail::TranscodeUTF8ToUTF16(data, length, characters).length);
+      }
+      
       // Prevent heap based objects.
       static void * operator new(std::size_t);     // #1: To prevent allocation of scalar objects
       static void * operator new [] (std::size_t); // #2: To prevent allocation of array of objects
@@ -190,15 +273,29 @@ namespace HAL {
       std::size_t    hash_value__;
 #pragma warning(pop)
       
-#undef HAL_JSSTRING_LOCK_GUARD
-#ifdef  HAL_THREAD_SAFE
-      std::recursive_mutex mutex__;
-#define HAL_JSSTRING_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock(mutex__)
-#else
+      // A JSStringRef is immutable and may be used on any thread, so
+      // there is nothing to check.
+#undef  HAL_JSSTRING_LOCK_GUARD
 #define HAL_JSSTRING_LOCK_GUARD
-#endif  // HAL_THREAD_SAFE
     };
     
+    inline
+    JSString::JSString(const char16_t* characters, std::size_t length)
+    : JSString(detail::JSStringRefHolder(JSStringCreateWithCharacters(reinterpret_cast<const JSChar*>(characters), length)).js_string_ref__) {
+    }
+    
+#ifdef HAL_STRING_VIEW_ENABLE
+    inline
+    JSString::JSString(std::string_view string)
+    : JSString(detail::JSStringRefHolder(CreateJSStringRef(string.data(), string.size())).js_string_ref__) {
+    }
+    
+    inline
+    JSString::JSString(std::u16string_view string)
+    : JSString(string.data(), string.size()) {
+    }
+#endif
+    
     inline
     std::string to_string(const JSString& js_string) {
       return static_cast<std::string>(js_string);
@@ -213,10 +310,118 @@ namespace HAL {
       return ! (lhs == rhs);
     }
     
-    // Define a strict weak ordering for two JSStrings.
+    namespace detail {
+      
+      // A read-only view of the UTF-16 code units of a string. JSStrings,
+      // JSStringRefs and UTF-16 strings are viewed in place, and UTF8
+      // strings are transcoded into a stack buffer unless they are
+      // long.
+      class JSStringUnits final {
+        
+      public:
+        
+        explicit JSStringUnits(const JSString& js_string) HAL_NOEXCEPT
+        : JSStringUnits(js_string.js_string_ref__) {
+        }
+        
+        explicit JSStringUnits(JSStringRef js_string_ref) HAL_NOEXCEPT
+        : data__(reinterpret_cast<const char16_t*>(JSStringGetCharactersPtr(js_string_ref)))
+        , size__(JSStringGetLength(js_string_ref)) {
+        }
+        
+        explicit JSStringUnits(const std::u16string& string) HAL_NOEXCEPT
+        : data__(string.data())
+        , size__(string.size()) {
+        }
+        
+        explicit JSStringUnits(const char16_t* string) HAL_NOEXCEPT
+        : data__(string)
+        , size__(std::char_traits<char16_t>::length(string)) {
+        }
+        
+        explicit JSStringUnits(const std::string& string)
+        : JSStringUnits(string.data(), string.size()) {
+        }
+        
+        explicit JSStringUnits(const char* string)
+        : JSStringUnits(string, std::strlen(string)) {
+        }
+        
+#ifdef HAL_STRING_VIEW_ENABLE
+        explicit JSStringUnits(std::u16string_view string) HAL_NOEXCEPT
+        : data__(string.data())
+        , size__(string.size()) {
+        }
+        
+        explicit JSStringUnits(std::string_view string)
+        : JSStringUnits(string.data(), string.size()) {
+        }
+#endif
+        
+        JSStringUnits(const char* data, std::size_t length) {
+          char16_t* characters = buffer__;
+          if (length > sizeof(buffer__) / sizeof(buffer__[0])) {
+            heap_buffer__.resize(length);
+            characters = &heap_buffer__[0];
+          }
+          data__ = characters;
+          size__ = TranscodeUTF8ToUTF16(data, length, characters).length;
+        }
+        
+        const char16_t* data() const HAL_NOEXCEPT {
+          return data__;
+        }
+        
+        std::size_t size() const HAL_NOEXCEPT {
+          return size__;
+        }
+        
+        // Return a negative number, zero or a positive number if lhs is
+        // ordered before, the same as or after rhs.
+        static int Compare(const JSStringUnits& lhs, const JSStringUnits& rhs) HAL_NOEXCEPT {
+          const std::size_t size = lhs.size__ < rhs.size__ ? lhs.size__ : rhs.size__;
+          for (std::size_t i = 0; i < size; ++i) {
+            if (lhs.data__[i] != rhs.data__[i]) {
+              return lhs.data__[i] < rhs.data__[i] ? -1 : 1;
+            }
+          }
+          return lhs.size__ < rhs.size__ ? -1 : (lhs.size__ > rhs.size__ ? 1 : 0);
+        }
+        
+        static bool Equal(const JSStringUnits& lhs, const JSStringUnits& rhs) HAL_NOEXCEPT {
+          return lhs.size__ == rhs.size__ && (lhs.size__ == 0 || std::memcmp(lhs.data__, rhs.data__, lhs.size__ * sizeof(char16_t)) == 0);
+        }
+        
+        // FNV-1a over the UTF-16 code units.
+        std::size_t Hash() const HAL_NOEXCEPT {
+          const bool is_64_bit = sizeof(std::size_t) > 4;
+          std::size_t hash        = is_64_bit ? static_cast<std::size_t>(14695981039346656037ULL) : 2166136261U;
+          const std::size_t prime = is_64_bit ? static_cast<std::size_t>(1099511628211ULL)        : 16777619U;
+          for (std::size_t i = 0; i < size__; ++i) {
+            hash ^= static_cast<std::size_t>(data__[i]);
+            hash *= prime;
+          }
+          return hash;
+        }
+        
+        JSStringUnits(const JSStringUnits&)            = delete;
+        JSStringUnits& operator=(const JSStringUnits&) = delete;
+        
+      private:
+        
+        const char16_t* data__ { nullptr };
+        std::size_t     size__ { 0 };
+        char16_t        buffer__[128];
+        std::u16string  heap_buffer__;
+      };
+      
+    } // namespace detail {
+    
+    // Define a strict weak ordering for two JSStrings by comparing their
+    // UTF-16 code units.
     inline
     bool operator<(const JSString& lhs, const JSString& rhs) {
-      return to_string(lhs) < to_string(rhs);
+      return detail::JSStringUnits::Compare(detail::JSStringUnits(lhs), detail::JSStringUnits(rhs)) < 0;
     }
     
     inline
@@ -234,6 +439,58 @@ namespace HAL {
       return !(lhs < rhs);
     }
     
+    /*!
+     @class
+     
+     @discussion A transparent ordering for JSString-keyed ordered
+     containers, such as std::map<JSString, T, JSStringLess>, that also
+     accepts JSStringRefs and UTF8 or UTF-16 strings. It orders the same
+     way as operator<.
+     */
+    struct JSStringLess final {
+      using is_transparent = void;
+      
+      template<typename L, typename R>
+      bool operator()(const L& lhs, const R& rhs) const {
+        return detail::JSStringUnits::Compare(detail::JSStringUnits(lhs), detail::JSStringUnits(rhs)) < 0;
+      }
+    };
+    
+    /*!
+     @class
+     
+     @discussion A transparent hash for JSString-keyed unordered
+     containers that also accepts JSStringRefs and UTF8 or UTF-16
+     strings. Equal strings hash the same whatever their type.
+     
+     Use it together with JSStringEqualTo, for example
+     std::unordered_map<JSString, T, JSStringHash, JSStringEqualTo>.
+     Looking such a map up by a key of another type requires C++20.
+     */
+    struct JSStringHash final {
+      using is_transparent = void;
+      
+      template<typename T>
+      std::size_t operator()(const T& string) const {
+        return detail::JSStringUnits(string).Hash();
+      }
+    };
+    
+    /*!
+     @class
+     
+     @discussion A transparent equality for JSString-keyed unordered
+     containers to use with JSStringHash.
+     */
+    struct JSStringEqualTo final {
+      using is_transparent = void;
+      
+      template<typename L, typename R>
+      bool operator()(const L& lhs, const R& rhs) const {
+        return detail::JSStringUnits::Equal(detail::JSStringUnits(lhs), detail::JSStringUnits(rhs));
+      }
+    };
+    
     inline
     std::ostream& operator << (std::ostream& ostream, const JSString& js_string) {
       ostream << to_string(js_string);
@@ -245,6 +502,101 @@ namespace HAL {
       first.swap(second);
     }
     
+    namespace detail {
+      
+      // Creates the JSStrings returned by operator"" _js.
+      struct JSStringLiteral final {
+        
+        // Return a JSString whose JSStringRef refers to a string
+        // literal's static storage, if HAL_PRIVATE_API_ENABLE allows
+        // it, instead of copying it.
+        static JSString Create(const char16_t* characters, std::size_t length) {
+          JSStringRefHolder js_string(CreateJSStringRefNoCopy(reinterpret_cast<const JSChar*>(characters), length));
+          return JSString(js_string.js_string_ref__);
+        }
+        
+        // Return a JSString for a narrow string literal, transcoded
+        // into a new JSStringRef.
+        static JSString Create(const char* string, std::size_t length) {
+          JSStringRefHolder js_string(JSString::CreateJSStringRef(string, length));
+          return JSString(js_string.js_string_ref__);
+        }
+      };
+      
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+      // A compile-time UTF-16 copy of an ASCII string literal.
+      template<std::size_t N>
+      struct JSStaticStringLiteral final {
+        constexpr JSStaticStringLiteral(const char (&string)[N]) {
+          for (std::size_t i = 0; i < N; ++i) {
+            if (static_cast<unsigned char>(string[i]) >= 0x80) {
+              throw "Use a u\"\"_js literal for strings that are not ASCII";
+            }
+            value[i] = static_cast<char16_t>(string[i]);
+          }
+        }
+        
+        char16_t value[N] {};
+      };
+#endif
+      
+    } // namespace detail {
+    
+    inline namespace literals {
+      
+      /*!
+       @function
+       
+       @abstract Create a JSString from a UTF-16 string literal, for
+       example u"width"_js.
+       
+       @discussion With HAL_PRIVATE_API_ENABLE the JSString's
+       JSStringRef refers directly to the literal's static storage, so
+       neither HAL nor JavaScriptCore copies the characters. Otherwise
+       JavaScriptCore copies them, but nothing is transcoded. Like
+       every JSString, it still builds its cached std::string when it
+       is created.
+       */
+      inline
+      JSString operator"" _js(const char16_t* characters, std::size_t length) {
+        return detail::JSStringLiteral::Create(characters, length);
+      }
+      
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+      /*!
+       @function
+       
+       @abstract Create a JSString from an ASCII string literal, for
+       example "width"_js.
+       
+       @discussion The literal is widened to UTF-16 at compile time,
+       and the JSString is created from that static buffer as for
+       u"width"_js.
+       */
+      template<detail::JSStaticStringLiteral literal>
+      JSString operator"" _js() {
+        return detail::JSStringLiteral::Create(literal.value, sizeof(literal.value) / sizeof(char16_t) - 1);
+      }
+#else
+      /*!
+       @function
+       
+       @abstract Create a JSString from a UTF8 string literal, for
+       example "width"_js.
+       
+       @discussion Before C++20 a narrow literal can't be widened at
+       compile time, so it is transcoded every time it is used, like
+       JSString(std::string_view). Use u"width"_js to refer to the
+       literal instead.
+       */
+      inline
+      JSString operator"" _js(const char* string, std::size_t length) {
+        return detail::JSStringLiteral::Create(string, length);
+      }
+#endif
+      
+    } // inline namespace literals {
+    
   } // namespace HAL {
   
   namespace std {
@@ -26,11 +26,15 @@ namespace HAL {
   class JSDate;
   class JSError;
   class JSRegExp;
+  class JSValueHandle;
   
   namespace detail {
     template<typename T>
     class JSExportClass;
     
+    template<typename T, typename Enable>
+    struct JSValueConverter;
+    
     HAL_EXPORT std::vector<JSValue>    to_vector(const JSContext&, size_t, const JSValueRef[]);
     HAL_EXPORT std::vector<JSValueRef> to_vector(const std::vector<JSValue>&);
   }}
@@ -344,6 +348,32 @@ namespace HAL {
     // operator JSValueRef() for SetPrototype().
     friend class JSObject;
     
+    // JSONWriter needs access to operator JSValueRef() to walk the
+    // value natively, and to the JSValue constructor for generating
+    // error messages.
+    friend class JSONWriter;
+    
+    // JSValueConverter needs access to operator JSValueRef() and the
+    // JSValue constructor to marshal C++ values without intermediate
+    // wrappers.
+    template<typename T, typename Enable>
+    friend struct detail::JSValueConverter;
+    
+    // JSPropertyView creates property values on demand.
+    friend class JSPropertyView;
+    
+    // JSValueHandle needs access to the JSValue constructor and
+    // operator JSValueRef(), and to js_context__ to avoid copying it.
+    friend class JSValueHandle;
+    
+    // JSNativeError creates its JavaScript Error object on demand.
+    friend class JSNativeError;
+    
+    // JSScriptBundle and JSModuleLoader evaluate scripts through the C
+    // API.
+    friend class JSScriptBundle;
+    friend class JSModuleLoader;
+    
     // For interoperability with the JavaScriptCore C API.
     JSValue(const JSContext& js_context, JSValueRef js_value_ref) HAL_NOEXCEPT;
     
@@ -379,13 +409,10 @@ namespace HAL {
     JSValueRef js_value_ref__ { nullptr };
 #pragma warning(pop)
     
+    // A JSValue belongs to the thread of its context group's executor,
+    // so it doesn't lock. Debug builds check the calling thread.
 #undef  HAL_JSVALUE_LOCK_GUARD
-#ifdef  HAL_THREAD_SAFE
-    std::recursive_mutex mutex__;
-#define HAL_JSVALUE_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock(mutex__)
-#else
-#define HAL_JSVALUE_LOCK_GUARD
-#endif  // HAL_THREAD_SAFE
+#define HAL_JSVALUE_LOCK_GUARD HAL_DETAIL_JSTHREADCONFINEMENT_CHECK(static_cast<JSContextRef>(js_context__))
   };
   
   inline
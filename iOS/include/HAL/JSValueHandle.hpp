@@ -0,0 +1,231 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_JSVALUEHANDLE_HPP_
+#define _HAL_JSVALUEHANDLE_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSValue.hpp"
+#include "HAL/JSNull.hpp"
+#include "HAL/detail/JSValueConverter.hpp"
+
+#include <utility>
+
+namespace HAL {
+
+  /*!
+   @class
+
+   @discussion A JSValueHandle is a compact alternative to JSValue for
+   storing many JavaScript values, for example in a
+   std::vector<JSValueHandle>. It is exactly two pointers wide: the
+   global context and the JSValueRef. It has no virtual functions and
+   no mutex, so copying one only retains the context and protects the
+   value from garbage collection.
+
+   A JSValueHandle doesn't provide JSValue's conversions. Use
+   get_value() to recover a full JSValue, and get_context() to recover
+   its JSContext, when they are needed.
+
+   A default constructed JSValueHandle is empty: it has neither a
+   context nor a JSValueRef. A JSValue that was marked as native
+   nullptr becomes a JSValueHandle with a context but a nullptr
+   JSValueRef, which get_value() turns back into a native nullptr
+   JSValue, and which otherwise behaves as JavaScript null.
+   */
+  class JSValueHandle final {
+
+  public:
+
+    /*!
+     @method
+
+     @abstract Create an empty JSValueHandle.
+     */
+    JSValueHandle() HAL_NOEXCEPT {
+    }
+
+    /*!
+     @method
+
+     @abstract Create a JSValueHandle that refers to the same JavaScript
+     value as the given JSValue.
+     */
+    explicit JSValueHandle(const JSValue& js_value) HAL_NOEXCEPT
+    : JSValueHandle(static_cast<JSContextRef>(js_value.js_context__), js_value.IsNativeNull() ? nullptr : static_cast<JSValueRef>(js_value)) {
+    }
+
+    /*!
+     @method
+
+     @abstract Return whether this JSValueHandle is empty.
+     */
+    bool empty() const HAL_NOEXCEPT {
+      return js_global_context_ref__ == nullptr;
+    }
+
+    /*!
+     @method
+
+     @abstract Return the JavaScript value's type without creating a
+     JSValue.
+
+     @discussion An empty JSValueHandle and a native nullptr have the
+     type JSValue::Type::Null.
+     */
+    JSValue::Type GetType() const HAL_NOEXCEPT {
+      if (js_value_ref__ == nullptr) {
+        return JSValue::Type::Null;
+      }
+      switch (JSValueGetType(js_global_context_ref__, js_value_ref__)) {
+        case kJSTypeUndefined: return JSValue::Type::Undefined;
+        case kJSTypeNull:      return JSValue::Type::Null;
+        case kJSTypeBoolean:   return JSValue::Type::Boolean;
+        case kJSTypeNumber:    return JSValue::Type::Number;
+        case kJSTypeString:    return JSValue::Type::String;
+        case kJSTypeObject:    return JSValue::Type::Object;
+      }
+      return JSValue::Type::Undefined;
+    }
+
+    /*!
+     @method
+
+     @abstract Return the execution context of this JavaScript value.
+
+     @discussion This must not be called on an empty JSValueHandle.
+     */
+    JSContext get_context() const HAL_NOEXCEPT {
+      return JSContext(js_global_context_ref__);
+    }
+
+    /*!
+     @method
+
+     @abstract Return a JSValue for this JavaScript value.
+
+     @discussion This must not be called on an empty JSValueHandle.
+     */
+    JSValue get_value() const HAL_NOEXCEPT {
+      const auto js_context = get_context();
+      if (js_value_ref__ == nullptr) {
+        JSValue js_value = js_context.CreateNull();
+        js_value.MarkAsNativeNull();
+        return js_value;
+      }
+      return JSValue(js_context, js_value_ref__);
+    }
+
+    explicit operator JSValue() const HAL_NOEXCEPT {
+      return get_value();
+    }
+
+    ~JSValueHandle() HAL_NOEXCEPT {
+      if (js_global_context_ref__) {
+        if (js_value_ref__) {
+          JSValueUnprotect(js_global_context_ref__, js_value_ref__);
+        }
+        JSGlobalContextRelease(js_global_context_ref__);
+      }
+    }
+
+    JSValueHandle(const JSValueHandle& rhs) HAL_NOEXCEPT
+    : JSValueHandle(rhs.js_global_context_ref__, rhs.js_value_ref__) {
+    }
+
+    JSValueHandle(JSValueHandle&& rhs) HAL_NOEXCEPT
+    : js_global_context_ref__(rhs.js_global_context_ref__)
+    , js_value_ref__(rhs.js_value_ref__) {
+      rhs.js_global_context_ref__ = nullptr;
+      rhs.js_value_ref__          = nullptr;
+    }
+
+    JSValueHandle& operator=(JSValueHandle rhs) HAL_NOEXCEPT {
+      swap(rhs);
+      return *this;
+    }
+
+    void swap(JSValueHandle& other) HAL_NOEXCEPT {
+      using std::swap;
+      swap(js_global_context_ref__, other.js_global_context_ref__);
+      swap(js_value_ref__         , other.js_value_ref__);
+    }
+
+  private:
+
+    template<typename T, typename Enable>
+    friend struct detail::JSValueConverter;
+
+    friend bool operator==(const JSValueHandle& lhs, const JSValueHandle& rhs) HAL_NOEXCEPT;
+
+    JSValueHandle(JSContextRef js_context_ref, JSValueRef js_value_ref) HAL_NOEXCEPT
+    : js_global_context_ref__(js_context_ref ? JSGlobalContextRetain(JSContextGetGlobalContext(js_context_ref)) : nullptr)
+    , js_value_ref__(js_context_ref ? js_value_ref : nullptr) {
+      if (js_value_ref__) {
+        JSValueProtect(js_global_context_ref__, js_value_ref__);
+      }
+    }
+
+    // For interoperability with the JavaScriptCore C API.
+    explicit operator JSValueRef() const HAL_NOEXCEPT {
+      return js_value_ref__;
+    }
+
+    JSGlobalContextRef js_global_context_ref__ { nullptr };
+    JSValueRef         js_value_ref__          { nullptr };
+  };
+
+  static_assert(sizeof(JSValueHandle) == 2 * sizeof(void*), "A JSValueHandle must be two pointers wide");
+
+  inline
+  void swap(JSValueHandle& first, JSValueHandle& second) HAL_NOEXCEPT {
+    first.swap(second);
+  }
+
+  // Return true if the two JSValueHandles refer to strict equal
+  // values, as compared by the JS === operator, where a native nullptr
+  // is JavaScript null. Empty handles are only equal to each other.
+  inline
+  bool operator==(const JSValueHandle& lhs, const JSValueHandle& rhs) HAL_NOEXCEPT {
+    if (lhs.empty() || rhs.empty()) {
+      return lhs.empty() && rhs.empty();
+    }
+    const auto js_context_ref = lhs.js_global_context_ref__;
+    const auto lhs_ref        = lhs.js_value_ref__ ? lhs.js_value_ref__ : JSValueMakeNull(js_context_ref);
+    const auto rhs_ref        = rhs.js_value_ref__ ? rhs.js_value_ref__ : JSValueMakeNull(js_context_ref);
+    return JSValueIsStrictEqual(js_context_ref, lhs_ref, rhs_ref);
+  }
+
+  inline
+  bool operator!=(const JSValueHandle& lhs, const JSValueHandle& rhs) HAL_NOEXCEPT {
+    return ! (lhs == rhs);
+  }
+
+  namespace detail {
+
+    // A JSValueHandle converts without creating a JSValue, so a
+    // std::vector<JSValueHandle> round trips through a JavaScript array
+    // at the cost of one protect per element.
+    template<>
+    struct JSValueConverter<JSValueHandle> {
+
+      static JSValueRef ToJSValueRef(JSContextRef, const JSValueHandle& js_value_handle) HAL_NOEXCEPT {
+        return static_cast<JSValueRef>(js_value_handle);
+      }
+
+      static JSValueHandle FromJSValueRef(JSContextRef js_context_ref, JSValueRef js_value_ref) HAL_NOEXCEPT {
+        return JSValueHandle(js_context_ref, js_value_ref);
+      }
+    };
+
+  } // namespace detail {
+
+} // namespace HAL {
+
+#endif // _HAL_JSVALUEHANDLE_HPP_
@@ -14,7 +14,6 @@
 // #define HAL_LOGGING_ENABLE_INFO
 #define HAL_LOGGING_ENABLE_WARN
 #define HAL_LOGGING_ENABLE_ERROR
-// #define HAL_THREAD_SAFE
 
 #define HAL_NOEXCEPT_ENABLE
 #define HAL_MOVE_CTOR_AND_ASSIGN_DEFAULT_ENABLE
@@ -44,22 +43,34 @@
 
 #endif  // #defined(_MSC_VER) && _MSC_VER <= 1800
 
+// std::string_view and std::u16string_view overloads are provided
+// when compiling as C++17 or later.
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define HAL_STRING_VIEW_ENABLE
+#endif
+
 #ifdef HAL_NOEXCEPT_ENABLE
 #define HAL_NOEXCEPT noexcept
 #else
 #define HAL_NOEXCEPT
 #endif
 
-#ifdef HAL_THREAD_SAFE
-#include <mutex>
-#endif
-
 #include "HAL_EXPORT.h"
 
 #include "HAL/detail/JSLogger.hpp"
 #include "HAL/detail/JSPerformanceCounter.hpp"
 #include <JavaScriptCore/JavaScript.h>
 
+// Debug builds assert that a JSContextGroup bound to a
+// JSContextGroupExecutor is only used on its executor thread. Define
+// HAL_THREAD_CONFINEMENT_CHECK_DISABLE to turn the assertions off.
+#if !defined(NDEBUG) && !defined(HAL_THREAD_CONFINEMENT_CHECK_DISABLE)
+#include "HAL/detail/JSThreadConfinement.hpp"
+#define HAL_DETAIL_JSTHREADCONFINEMENT_CHECK(js_context_ref) HAL::detail::JSThreadConfinement::Check(js_context_ref)
+#else
+#define HAL_DETAIL_JSTHREADCONFINEMENT_CHECK(js_context_ref)
+#endif
+
 /*!
   @function
   @abstract Gets the global context of a JavaScript execution context.
@@ -68,4 +79,49 @@
 */
 extern "C" JSGlobalContextRef JSContextGetGlobalContext(JSContextRef ctx);
 
+// Add -DHAL_PRIVATE_API_ENABLE=1 to use JavaScriptCore functions
+// that aren't part of its public API where HAL has a fallback for
+// them or can do without them.
+#ifdef HAL_PRIVATE_API_ENABLE
+
+/*!
+  @function
+  @abstract Reports an object's non-GC memory payload to the garbage collector.
+  @param ctx The execution context to use.
+  @param size The payload's size, in bytes.
+  @discussion Use this function to notify the garbage collector that a GC object
+  owns a large non-GC memory region. Calling this function will encourage the
+  garbage collector to collect this object.
+*/
+extern "C" void JSReportExtraMemoryCost(JSContextRef ctx, size_t size);
+
+/*!
+  @function
+  @abstract Creates a JavaScript string from a buffer of Unicode characters without copying them.
+  @param chars The buffer of Unicode characters to use. It must outlive the returned string.
+  @param numChars The number of characters in chars.
+  @result A JSString containing chars. Ownership follows the Create Rule.
+*/
+extern "C" JSStringRef JSStringCreateWithCharactersNoCopy(const JSChar* chars, size_t numChars);
+
+#endif  // HAL_PRIVATE_API_ENABLE
+
+// JSLeakDetector waits for a full collection with a JavaScriptCore
+// function that isn't part of its public API, so it is only declared
+// when -DHAL_LEAK_DETECTOR_ENABLE=1 is added, and release builds never
+// link it.
+#ifdef HAL_LEAK_DETECTOR_ENABLE
+
+/*!
+  @function
+  @abstract Performs a full garbage collection and returns when it is complete.
+  @param ctx The execution context to use.
+  @discussion Unlike JSGarbageCollect, which only asks for a collection, this
+  blocks the calling thread until unreachable objects are collected and their
+  finalizers have run.
+*/
+extern "C" void JSSynchronousGarbageCollectForDebugging(JSContextRef ctx);
+
+#endif  // HAL_LEAK_DETECTOR_ENABLE
+
 #endif  // _HAL_DETAIL_JSBASE_HPP_
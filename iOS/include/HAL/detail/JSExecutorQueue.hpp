@@ -0,0 +1,262 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_DETAIL_JSEXECUTORQUEUE_HPP_
+#define _HAL_DETAIL_JSEXECUTORQUEUE_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace HAL { namespace detail {
+
+  // The type JSContextGroup::Invoke returns for a callable.
+  template<typename Callable>
+  using JSInvokeResult_t = typename std::decay<decltype(std::declval<Callable&>()())>::type;
+
+  /*!
+   @class
+
+   @discussion A JSExecutorQueue is the task queue of a
+   JSContextGroupExecutor. Any number of threads push tasks, and the
+   executor thread runs them in the order they were pushed.
+
+   Pushing is lock-free: it allocates a node, swaps it into the head of
+   an intrusive singly linked list and links it to its predecessor. The
+   executor thread pops from the tail without synchronizing with the
+   producers. Only when the executor thread has run out of tasks does
+   it sleep on a condition variable, and a producer takes the mutex to
+   wake it only if it is sleeping.
+
+   Each producer counts itself in producers__ for the duration of a
+   Push. Close sets closed__ and then waits for producers__ to drain
+   before sealing the queue, so every Push either fails or has linked
+   its node before Run can see the queue sealed and return. A node that
+   is never run is destroyed with its task, which breaks the promise of
+   a JSContextGroup::Invoke waiting on it.
+   */
+  class JSExecutorQueue final {
+
+  public:
+
+    using Task = std::function<void()>;
+
+    JSExecutorQueue() HAL_NOEXCEPT
+    : head__(&stub__)
+    , tail__(&stub__) {
+    }
+
+    ~JSExecutorQueue() HAL_NOEXCEPT {
+      // Tasks that were never run are destroyed without running them.
+      while (Node* node = Pop()) {
+        delete node;
+      }
+    }
+
+    /*!
+     @method
+
+     @abstract Add a task to the queue from any thread.
+
+     @result false if the queue was closed, in which case the task is
+     not run.
+     */
+    bool Push(Task task) {
+      ProducerGuard producer(*this);
+      if (closed__.load()) {
+        return false;
+      }
+      Node* node = new Node(std::move(task));
+      Node* prev = head__.exchange(node);
+      prev -> next.store(node);
+      if (waiting__.load()) {
+        std::lock_guard<std::mutex> lock(mutex__);
+        condition__.notify_all();
+      }
+      return true;
+    }
+
+    /*!
+     @method
+
+     @abstract Run tasks on the calling thread until the queue is
+     closed and every task pushed before closing has run.
+     */
+    void Run() {
+      RunUntilSealed();
+      // Nothing can be linked after the queue is sealed, so this only
+      // guards against a task left behind by a bug: destroying it
+      // breaks its promise rather than leaving a caller blocked.
+      while (Node* node = Pop()) {
+        HAL_LOG_ERROR("JSExecutorQueue: dropping a task that was pushed after the queue was sealed");
+        delete node;
+      }
+    }
+
+    /*!
+     @method
+
+     @abstract Stop accepting tasks and wait for the producers already
+     inside Push to finish linking their tasks. Run returns once every
+     task pushed before closing has run.
+     */
+    void Close() {
+      closed__.store(true);
+      std::unique_lock<std::mutex> lock(mutex__);
+      condition__.wait(lock, [this] { return producers__.load() == 0; });
+      sealed__.store(true);
+      condition__.notify_all();
+    }
+
+    bool IsCurrentThread() const HAL_NOEXCEPT {
+      return thread_id__ == std::this_thread::get_id();
+    }
+
+    // Set before the queue is shared with any producer.
+    void set_thread_id(std::thread::id thread_id) HAL_NOEXCEPT {
+      thread_id__ = thread_id;
+    }
+
+    JSExecutorQueue(const JSExecutorQueue&)            = delete;
+    JSExecutorQueue& operator=(const JSExecutorQueue&) = delete;
+
+  private:
+
+    // Counts a producer in producers__ while it is inside Push, and
+    // wakes Close when the last producer of a closed queue leaves.
+    class ProducerGuard final {
+
+    public:
+
+      explicit ProducerGuard(JSExecutorQueue& queue) HAL_NOEXCEPT
+      : queue__(queue) {
+        queue__.producers__.fetch_add(1);
+      }
+
+      ~ProducerGuard() HAL_NOEXCEPT {
+        if (queue__.producers__.fetch_sub(1) == 1 && queue__.closed__.load()) {
+          std::lock_guard<std::mutex> lock(queue__.mutex__);
+          queue__.condition__.notify_all();
+        }
+      }
+
+      ProducerGuard(const ProducerGuard&)            = delete;
+      ProducerGuard& operator=(const ProducerGuard&) = delete;
+
+    private:
+
+      JSExecutorQueue& queue__;
+    };
+
+    void RunUntilSealed() {
+      for (;;) {
+        Node* node = Pop();
+        if (node == nullptr) {
+          std::unique_lock<std::mutex> lock(mutex__);
+          waiting__.store(true);
+          // Look again after publishing waiting__, so that a task
+          // pushed by a producer that missed it isn't left behind.
+          node = Pop();
+          if (node == nullptr) {
+            if (sealed__.load()) {
+              waiting__.store(false);
+              return;
+            }
+            condition__.wait(lock);
+          }
+          waiting__.store(false);
+        }
+        if (node) {
+          RunTask(node);
+        }
+      }
+    }
+
+    struct Node final {
+
+      Node() HAL_NOEXCEPT = default;
+
+      explicit Node(Task task)
+      : task(std::move(task)) {
+      }
+
+      std::atomic<Node*> next { nullptr };
+      Task               task;
+    };
+
+    static void RunTask(Node* node) HAL_NOEXCEPT {
+      try {
+        node -> task();
+      } catch (const std::exception& e) {
+        HAL_LOG_ERROR("JSExecutorQueue: task threw ", e.what());
+      } catch (...) {
+        HAL_LOG_ERROR("JSExecutorQueue: task threw an unknown exception");
+      }
+      delete node;
+    }
+
+    // Remove the oldest task, or return nullptr if there is none or if
+    // the oldest one is still being linked by its producer. Only the
+    // executor thread calls Pop.
+    Node* Pop() HAL_NOEXCEPT {
+      Node* tail = tail__;
+      Node* next = tail -> next.load();
+      if (tail == &stub__) {
+        if (next == nullptr) {
+          return nullptr;
+        }
+        tail__ = next;
+        tail   = next;
+        next   = next -> next.load();
+      }
+      if (next) {
+        tail__ = next;
+        return tail;
+      }
+      if (tail != head__.load()) {
+        return nullptr;
+      }
+      // The tail is the last node. Put the stub behind it so that the
+      // tail can be removed without touching the head.
+      stub__.next.store(nullptr);
+      Node* prev = head__.exchange(&stub__);
+      prev -> next.store(&stub__);
+      next = tail -> next.load();
+      if (next) {
+        tail__ = next;
+        return tail;
+      }
+      return nullptr;
+    }
+
+    // Producers only touch head__, and the executor thread only touches
+    // tail__.
+    std::atomic<Node*>      head__;
+    Node*                   tail__;
+    Node                    stub__;
+
+    std::atomic<bool>       waiting__ { false };
+    std::atomic<bool>       closed__  { false };
+    std::atomic<bool>       sealed__  { false };
+    std::atomic<std::size_t> producers__ { 0 };
+    std::mutex              mutex__;
+    std::condition_variable condition__;
+    std::thread::id         thread_id__;
+  };
+
+}} // namespace HAL { namespace detail {
+
+#endif // _HAL_DETAIL_JSEXECUTORQUEUE_HPP_
@@ -13,6 +13,7 @@
 #include "HAL/JSClass.hpp"
 #include "HAL/detail/JSExportClassDefinition.hpp"
 
+#include "HAL/JSContextView.hpp"
 #include "HAL/JSString.hpp"
 #include "HAL/JSValue.hpp"
 #include "HAL/JSObject.hpp"
@@ -20,16 +21,18 @@
 #include "HAL/JSError.hpp"
 #include "HAL/JSArray.hpp"
 
+#include "HAL/detail/JSExportPrivateData.hpp"
 #include "HAL/detail/JSPropertyNameAccumulator.hpp"
 #include "HAL/detail/JSUtil.hpp"
 #include "HAL/detail/JSValueUtil.hpp"
 
 #include <string>
-#include <regex>
 #include <cstdint>
 #include <vector>
 #include <memory>
 #include <utility>
+#include <type_traits>
+#include <cstddef>
 #include <typeinfo>
 #include <typeindex>
 
@@ -62,7 +65,7 @@ namespace HAL { namespace detail {
     
   public:
     
-    JSExportClass(const JSExportClassDefinition<T>& js_export_class_definition) HAL_NOEXCEPT;
+    JSExportClass(const JSExportClassDefinitionPtr_t<T>& js_export_class_definition) HAL_NOEXCEPT;
     
     JSExportClass()                                HAL_NOEXCEPT;//= default;
     ~JSExportClass()                               HAL_NOEXCEPT;//= default;
@@ -94,8 +97,21 @@ namespace HAL { namespace detail {
     static JSValueRef  GetNamedValuePropertyCallback(JSContextRef context_ref, JSObjectRef object_ref, JSStringRef property_name_ref, JSValueRef* exception);
     static bool        SetNamedValuePropertyCallback(JSContextRef context_ref, JSObjectRef object_ref, JSStringRef property_name_ref, JSValueRef value_ref, JSValueRef* exception);
     
-    // Support for JSStaticFunction
+    // Support for JSStaticFunction. Each static function gets its own
+    // CallNamedFunctionCallbackAt<I> trampoline, where I is the
+    // function's index in the frozen definition, so calling it needs
+    // no lookup. Functions past the end of the trampoline table fall
+    // back to CallNamedFunctionCallback, which looks the function up
+    // by its "name" property.
+    typedef std::integral_constant<std::size_t, 32> CallNamedFunctionCallbackCount_t;
+    static ::JSObjectCallAsFunctionCallback GetCallNamedFunctionCallback(std::size_t index);
+    template<std::size_t I>
+    static ::JSObjectCallAsFunctionCallback GetCallNamedFunctionCallback(std::size_t index, std::integral_constant<std::size_t, I>);
+    static ::JSObjectCallAsFunctionCallback GetCallNamedFunctionCallback(std::size_t index, CallNamedFunctionCallbackCount_t);
+    template<std::size_t I>
+    static JSValueRef  CallNamedFunctionCallbackAt(JSContextRef context_ref, JSObjectRef function_ref, JSObjectRef this_object_ref, size_t argument_count, const JSValueRef arguments_array[], JSValueRef* exception);
     static JSValueRef  CallNamedFunctionCallback(JSContextRef context_ref, JSObjectRef function_ref, JSObjectRef this_object_ref, size_t argument_count, const JSValueRef arguments_array[], JSValueRef* exception);
+    static JSValueRef  CallNamedFunction(const JSExportNamedFunctionPropertyCallback<T>& function_property_callback, JSContextRef context_ref, JSObjectRef function_ref, JSObjectRef this_object_ref, size_t argument_count, const JSValueRef arguments_array[], JSValueRef* exception);
     
     // JavaScriptCore C API callback interface.
     static void        JSObjectInitializeCallback(JSContextRef context_ref, JSObjectRef object_ref);
@@ -111,29 +127,35 @@ namespace HAL { namespace detail {
     static JSValueRef  JSObjectConvertToTypeCallback(JSContextRef context_ref, JSObjectRef object_ref, JSType type, JSValueRef* exception);
     
     // Helper functions.
-    static JSValue CreateJSError(const std::string& function_name, const std::string& location, JSObject js_object, const js_runtime_error& e);
-    static JSValue CreateJSError(const std::string& function_name, JSObject js_object, const std::exception& e);
-    static JSValue CreateJSError(const std::string& function_name, JSObject js_object, const std::string& what);
+    static JSValue CreateJSError(const std::string& function_name, const std::string& location, const JSObject& js_object, const js_runtime_error& e);
+    static JSValue CreateJSError(const std::string& function_name, const JSObject& js_object, const std::exception& e);
+    static JSValue CreateJSError(const std::string& function_name, const JSObject& js_object, const std::string& what);
     static std::string GetJSExportComponentName(const std::string& function_name, const std::string& location = "");
     
-    static JSExportClassDefinition<T> js_export_class_definition__;
+    // JSExport<T>::FindJSObject needs access to the JSObject
+    // constructor.
+    friend class JSExport<T>;
+    static JSObject FindJSObject(const JSContext& js_context, void* private_data);
     
-#undef HAL_DETAIL_JSEXPORTCLASS_LOCK_GUARD_STATIC
-#ifdef HAL_THREAD_SAFE
-    static std::recursive_mutex mutex_static__;
-#define HAL_DETAIL_JSEXPORTCLASS_LOCK_GUARD_STATIC std::lock_guard<std::recursive_mutex> lock_static(JSExportClass::mutex_static__)
-#else
-#define HAL_DETAIL_JSEXPORTCLASS_LOCK_GUARD_STATIC
-#endif  // HAL_THREAD_SAFE
+    // JSExport<T>::ReportExtraMemory needs access to the JSObjectRef.
+    static void ReportExtraMemory(const JSObject& js_object, std::size_t bytes);
+    
+    // Report the result of the native object's SizeOf() as its extra
+    // memory, if T has a SizeOf() member function.
+    template<typename U>
+    static auto ReportSizeOf(JSContextRef context_ref, U* native_object_ptr, int) -> decltype(native_object_ptr -> SizeOf(), void());
+    template<typename U>
+    static void ReportSizeOf(JSContextRef, U*, long) HAL_NOEXCEPT {
+    }
+    
+    // The frozen definition is shared, never copied. It is set once,
+    // under JSExport<T>::Class()'s once flag, before any callback can
+    // run, so reading it doesn't lock.
+    static JSExportClassDefinitionPtr_t<T> js_export_class_definition__;
   };
-
-#ifdef HAL_THREAD_SAFE
-  template<typename T>
-  std::recursive_mutex JSExportClass<T>::mutex_static__;
-#endif
   
   template<typename T>
-  JSExportClassDefinition<T> JSExportClass<T>::js_export_class_definition__;
+  JSExportClassDefinitionPtr_t<T> JSExportClass<T>::js_export_class_definition__;
   
   template<typename T>
   JSExportClass<T>::JSExportClass() HAL_NOEXCEPT {
@@ -141,12 +163,12 @@ namespace HAL { namespace detail {
   }
 
   template<typename T>
-  JSExportClass<T>::JSExportClass(const JSExportClassDefinition<T>& js_export_class_definition) HAL_NOEXCEPT
-  : JSClass(js_export_class_definition) {
-    HAL_DETAIL_JSEXPORTCLASS_LOCK_GUARD_STATIC;
+  JSExportClass<T>::JSExportClass(const JSExportClassDefinitionPtr_t<T>& js_export_class_definition) HAL_NOEXCEPT
+  : JSClass(*js_export_class_definition) {
     HAL_LOG_TRACE("JSExportClass<", typeid(T).name(), ">:: ctor 2 ", this);
     js_export_class_definition__ = js_export_class_definition;
-    //js_export_class_definition__.Print();
+    JSExportTypeInfo<T>::js_class_ref.store(static_cast<JSClassRef>(*this), std::memory_order_release);
+    //js_export_class_definition__ -> Print();
   }
   
   template<typename T>
@@ -157,13 +179,13 @@ namespace HAL { namespace detail {
   template<typename T>
   void JSExportClass<T>::Print() const {
     HAL_JSCLASS_LOCK_GUARD;
-    for (const auto& entry : js_export_class_definition__.named_value_property_callback_map__) {
+    for (const auto& entry : js_export_class_definition__ -> named_value_property_callback_map__) {
       const auto& name       = entry.first;
       const auto& attributes = entry.second.get_attributes();
       HAL_LOG_DEBUG("JSExportClass: has value property callback ", name, " with attributes ", to_string(attributes));
     }
     
-    for (const auto& entry : js_export_class_definition__.named_function_property_callback_map__) {
+    for (const auto& entry : js_export_class_definition__ -> named_function_property_callback_map__) {
       const auto& name       = entry.first;
       const auto& attributes = entry.second.get_attributes();
       HAL_LOG_DEBUG("JSExportClass: has function property callback ", name, " with attributes ", to_string(attributes));
@@ -172,6 +194,11 @@ namespace HAL { namespace detail {
   
   // The static functions that implement the JavaScriptCore C API
   // callbacks begin here.
+  //
+  // Callbacks that only need the native object read it straight from
+  // the JSObjectRef, and borrow the JSContextRef through a
+  // JSContextView, so they don't look up or copy a JSContext unless
+  // they create a JSValue or report an error.
   
   template<typename T>
   void JSExportClass<T>::JSObjectInitializeCallback(JSContextRef context_ref, JSObjectRef object_ref) {
@@ -179,32 +206,68 @@ namespace HAL { namespace detail {
     JSObject js_object(JSContext(context_ref), object_ref);
     HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::Initialize: JSContextRef = ", context_ref, ", JSObjectRef = ", object_ref);
 
-    const auto previous_native_object_ptr = static_cast<JSExport<T>*>(js_object.GetPrivate());
-    const auto native_object_ptr          = new T(js_object.get_context());
+    // The parent class' initialize callback runs first, so the native
+    // object it created is replaced by one of the derived class. The
+    // header of each native object knows how to destroy it.
+    const auto previous_native_object_ptr = js_object.GetPrivate();
+    const auto native_object_ptr          = JSExportPrivateData<T>::Create(js_object.get_context());
+    HAL_DETAIL_JSLEAKREGISTRY_TRACK(native_object_ptr, typeid(T).name(), context_ref);
     
     if (previous_native_object_ptr != nullptr) {
       HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::Initialize: replace ", previous_native_object_ptr, " with ", native_object_ptr, " for ", object_ref);
-      delete previous_native_object_ptr;
+      JSExportPrivateDataHeader::InheritExtraMemory(native_object_ptr, previous_native_object_ptr);
+      JSExportPrivateDataHeader::Destroy(previous_native_object_ptr);
     }
     
     const bool result = js_object.SetPrivate(native_object_ptr);
     HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::Initialize: private data set to ", js_object.GetPrivate(), " for ", object_ref);
+    JSExportPrivateDataHeader::SetJSObject(native_object_ptr, context_ref, object_ref);
     
     native_object_ptr->postInitialize(js_object);
+    ReportSizeOf(context_ref, native_object_ptr, 0);
     
     assert(result);
   }
   
+  template<typename T>
+  JSObject JSExportClass<T>::FindJSObject(const JSContext& js_context, void* private_data) {
+    const auto header         = JSExportPrivateDataHeader::Get(private_data);
+    const auto js_context_ref = static_cast<JSContextRef>(js_context);
+    const auto js_object_ref  = JSExportPrivateDataHeader::GetJSObject(private_data);
+    if (js_object_ref == nullptr) {
+      ThrowRuntimeError(GetJSExportComponentName("FindJSObject"), "native object has no JavaScript object yet");
+    }
+    if (header -> js_context_group_ref != JSContextGetGroup(js_context_ref)) {
+      ThrowRuntimeError(GetJSExportComponentName("FindJSObject"), "native object's JavaScript object belongs to another JSContextGroup");
+    }
+    return JSObject(js_context, js_object_ref);
+  }
+  
+  template<typename T>
+  void JSExportClass<T>::ReportExtraMemory(const JSObject& js_object, std::size_t bytes) {
+    const auto js_context_ref = static_cast<JSContextRef>(js_object.get_context());
+    const auto private_data   = JSExportPrivateData<T>::Find(js_context_ref, static_cast<JSObjectRef>(js_object));
+    if (private_data == nullptr) {
+      ThrowRuntimeError(GetJSExportComponentName("ReportExtraMemory"), "JavaScript object was not created by this JSExport class or a class derived from it");
+    }
+    JSExportPrivateDataHeader::ReportExtraMemory(js_context_ref, private_data, bytes);
+  }
+  
+  template<typename T>
+  template<typename U>
+  auto JSExportClass<T>::ReportSizeOf(JSContextRef context_ref, U* native_object_ptr, int) -> decltype(native_object_ptr -> SizeOf(), void()) {
+    const std::size_t size = native_object_ptr -> SizeOf();
+    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::Initialize: report ", size, " bytes of extra memory for ", native_object_ptr);
+    JSExportPrivateDataHeader::ReportExtraMemory(context_ref, native_object_ptr, size);
+  }
+  
   template<typename T>
   void JSExportClass<T>::JSObjectFinalizeCallback(JSObjectRef object_ref) {
-    HAL_DETAIL_JSEXPORTCLASS_LOCK_GUARD_STATIC;
-    
-    auto native_object_ptr = static_cast<JSExport<T>*>(JSObjectGetPrivate(object_ref));
+    auto native_object_ptr = JSObjectGetPrivate(object_ref);
     
     HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::Finalize: delete native object ", native_object_ptr, " for ", object_ref);
     if (native_object_ptr) {
-      //delete reinterpret_cast<T*>(native_object_ptr);
-      delete native_object_ptr;
+      JSExportPrivateDataHeader::Destroy(native_object_ptr);
       JSObjectSetPrivate(object_ref, nullptr);
     }
   }
@@ -212,24 +275,22 @@ namespace HAL { namespace detail {
   template<typename T>
   JSValueRef JSExportClass<T>::GetNamedValuePropertyCallback(JSContextRef context_ref, JSObjectRef object_ref, JSStringRef property_name_ref, JSValueRef* exception) try {
     
-    JSObject js_object(JSObject::FindJSObject(context_ref, object_ref));
-    
     const std::string property_name = JSString(property_name_ref);
     
-    const auto callback_position = js_export_class_definition__.named_value_property_callback_map__.find(property_name);
-    const bool callback_found    = callback_position != js_export_class_definition__.named_value_property_callback_map__.end();
+    const auto callback_position = js_export_class_definition__ -> named_value_property_callback_map__.find(property_name);
+    const bool callback_found    = callback_position != js_export_class_definition__ -> named_value_property_callback_map__.end();
     
-    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::GetNamedProperty: callback found = ", callback_found, " for ", to_string(js_object), ".", property_name);
+    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::GetNamedProperty: callback found = ", callback_found, " for ", object_ref, ".", property_name);
     
     // precondition
     assert(callback_found);
     
     try {
-      const auto native_object_ptr = static_cast<const T*>(js_object.GetPrivate());
+      const auto native_object_ptr = static_cast<const T*>(JSObjectGetPrivate(object_ref));
       const auto callback          = (callback_position -> second).get_callback();
       const auto result            = callback(*native_object_ptr);
       
-      HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::GetNamedProperty: result = ", to_string(result), " for ", to_string(js_object), ".", property_name);
+      HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::GetNamedProperty: result = ", to_string(result), " for ", object_ref, ".", property_name);
       
       return static_cast<JSValueRef>(result);
 
@@ -252,25 +313,24 @@ namespace HAL { namespace detail {
   template<typename T>
   bool JSExportClass<T>::SetNamedValuePropertyCallback(JSContextRef context_ref, JSObjectRef object_ref, JSStringRef property_name_ref, JSValueRef value_ref, JSValueRef* exception) try {
     
-    JSObject js_object(JSObject::FindJSObject(context_ref, object_ref));
-    JSValue  js_value(js_object.get_context(), value_ref);
+    const JSContextView js_context_view(context_ref);
     
     const std::string property_name = JSString(property_name_ref);
     
-    const auto callback_position = js_export_class_definition__.named_value_property_callback_map__.find(property_name);
-    const bool callback_found    = callback_position != js_export_class_definition__.named_value_property_callback_map__.end();
+    const auto callback_position = js_export_class_definition__ -> named_value_property_callback_map__.find(property_name);
+    const bool callback_found    = callback_position != js_export_class_definition__ -> named_value_property_callback_map__.end();
     
-    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::SetNamedProperty: callback found = ", callback_found, " for ", to_string(js_object), ".", property_name);
+    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::SetNamedProperty: callback found = ", callback_found, " for ", object_ref, ".", property_name);
     
     // precondition
     assert(callback_found);
     
     try {
-      auto native_object_ptr = static_cast<T*>(js_object.GetPrivate());
+      auto native_object_ptr = static_cast<T*>(JSObjectGetPrivate(object_ref));
       const auto callback    = (callback_position -> second).set_callback();
-      const auto result      = callback(*native_object_ptr, js_value);
+      const auto result      = callback(*native_object_ptr, JSValue(js_context_view.Promote(), value_ref));
       
-      HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::SetNamedProperty: result = ", result, " for ", to_string(js_object), ".", property_name);
+      HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::SetNamedProperty: result = ", result, " for ", object_ref, ".", property_name);
       
       return result;
 
@@ -291,51 +351,70 @@ namespace HAL { namespace detail {
   }
   
   template<typename T>
-  JSValueRef JSExportClass<T>::CallNamedFunctionCallback(JSContextRef context_ref, JSObjectRef function_ref, JSObjectRef this_object_ref, size_t argument_count, const JSValueRef arguments_array[], JSValueRef* exception) try {
-    // to_string(js_object) produces this text:
-    //
-    // function sayHello() {
-    //     [native code]
-    // }
-    //
-    // So this is the regular expression we use to determing the
-    // function's name for lookup.
-    static std::regex regex("^function\\s+([^(]+)\\(\\)(.|\\n)*$");
-    
-    JSObject          js_object(JSObject::FindJSObject(context_ref, function_ref));
-    JSObject          this_object(JSObject::FindJSObject(context_ref, this_object_ref));
-    const std::string js_object_string = to_string(js_object);
-    std::smatch       match_results;
-    const bool        found = std::regex_match(js_object_string, match_results, regex);
-
-    static_cast<void>(found);
-    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::CallNamedFunction: function name found = ", found, ", match_results.size() = ", match_results.size(), ", input = ", js_object_string);
+  ::JSObjectCallAsFunctionCallback JSExportClass<T>::GetCallNamedFunctionCallback(std::size_t index) {
+    return GetCallNamedFunctionCallback(index, std::integral_constant<std::size_t, 0>());
+  }
+  
+  template<typename T>
+  template<std::size_t I>
+  ::JSObjectCallAsFunctionCallback JSExportClass<T>::GetCallNamedFunctionCallback(std::size_t index, std::integral_constant<std::size_t, I>) {
+    return index == I ? CallNamedFunctionCallbackAt<I> : GetCallNamedFunctionCallback(index, std::integral_constant<std::size_t, I + 1>());
+  }
+  
+  template<typename T>
+  ::JSObjectCallAsFunctionCallback JSExportClass<T>::GetCallNamedFunctionCallback(std::size_t, CallNamedFunctionCallbackCount_t) {
+    return CallNamedFunctionCallback;
+  }
+  
+  template<typename T>
+  template<std::size_t I>
+  JSValueRef JSExportClass<T>::CallNamedFunctionCallbackAt(JSContextRef context_ref, JSObjectRef function_ref, JSObjectRef this_object_ref, size_t argument_count, const JSValueRef arguments_array[], JSValueRef* exception) {
+    const auto& named_function_property_callbacks = js_export_class_definition__ -> named_function_property_callbacks__;
     
     // precondition
-    // The size of the match results should be 3:
-    // match_results[0] == the whole string.
-    // match_results[1] == The function's name
-    // match_results[2] == Everything after the function's name.
-    assert(match_results.size() == 3);
-    const std::string function_name = match_results[1];
+    assert(I < named_function_property_callbacks.size());
     
-    // precondition
-    assert(js_object.IsFunction());
+    return CallNamedFunction(*named_function_property_callbacks[I], context_ref, function_ref, this_object_ref, argument_count, arguments_array, exception);
+  }
+  
+  template<typename T>
+  JSValueRef JSExportClass<T>::CallNamedFunctionCallback(JSContextRef context_ref, JSObjectRef function_ref, JSObjectRef this_object_ref, size_t argument_count, const JSValueRef arguments_array[], JSValueRef* exception) try {
+    // JavaScriptCore names the function object it creates for a
+    // JSStaticFunction after the static function, so its "name"
+    // property is the key for the lookup.
+    JSObject          js_object(JSObject::FindJSObject(context_ref, function_ref));
+    const std::string function_name = static_cast<std::string>(js_object.GetProperty("name"));
     
-    const auto callback_position = js_export_class_definition__.named_function_property_callback_map__.find(function_name);
-    const bool callback_found    = callback_position != js_export_class_definition__.named_function_property_callback_map__.end();
-    const auto native_object_ptr = static_cast<T*>(js_object.GetPrivate());
-    const auto native_this_ptr   = static_cast<T*>(this_object.GetPrivate());
-
-    static_cast<void>(native_object_ptr);
-    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::CallNamedFunction: callback found = ", callback_found, " for this[", native_this_ptr, "].", function_name, "(...)");
+    const auto callback_position = js_export_class_definition__ -> named_function_property_callback_map__.find(function_name);
+    const bool callback_found    = callback_position != js_export_class_definition__ -> named_function_property_callback_map__.end();
+    
+    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::CallNamedFunction: callback found = ", callback_found, " for ", this_object_ref, ".", function_name, "(...)");
     
     // precondition
     assert(callback_found);
-
+    
+    return CallNamedFunction(callback_position -> second, context_ref, function_ref, this_object_ref, argument_count, arguments_array, exception);
+    
+  } catch (const std::exception& e) {
+    JSObject js_object(JSObject::FindJSObject(context_ref, function_ref));
+    *exception = static_cast<JSValueRef>(CreateJSError("CallNamedFunction", js_object, e));
+    return nullptr;
+  } catch (...) {
+    JSObject js_object(JSObject::FindJSObject(context_ref, function_ref));
+    *exception = static_cast<JSValueRef>(CreateJSError("CallNamedFunction", js_object, "unknown exception"));
+    return nullptr;
+  }
+  
+  template<typename T>
+  JSValueRef JSExportClass<T>::CallNamedFunction(const JSExportNamedFunctionPropertyCallback<T>& function_property_callback, JSContextRef context_ref, JSObjectRef function_ref, JSObjectRef this_object_ref, size_t argument_count, const JSValueRef arguments_array[], JSValueRef* exception) try {
+    JSObject   this_object(JSObject::FindJSObject(context_ref, this_object_ref));
+    const auto native_this_ptr = static_cast<T*>(JSObjectGetPrivate(this_object_ref));
+    
+    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::CallNamedFunction: calling this[", native_this_ptr, "].", function_property_callback.get_name(), "(...)");
+    
     try {
-      const auto callback = (callback_position -> second).function_callback();
-      const auto result   = callback(*native_this_ptr, to_vector(this_object.get_context(), argument_count, arguments_array), this_object);
+      const auto& callback = function_property_callback.function_callback();
+      const auto  result   = callback(*native_this_ptr, to_vector(this_object.get_context(), argument_count, arguments_array), this_object);
       
 #ifdef HAL_LOGGING_ENABLE
       std::string js_value_str;
@@ -348,14 +427,14 @@ namespace HAL { namespace detail {
         js_value_str = to_string(result);
       }
       
-      HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::CallNamedFunction: result = ", js_value_str, " for this[", native_this_ptr, "].", function_name, "(...)");
+      HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::CallNamedFunction: result = ", js_value_str, " for this[", native_this_ptr, "].", function_property_callback.get_name(), "(...)");
 #endif
       
       return static_cast<JSValueRef>(result);
 
     } catch (const js_runtime_error& e) {
       JSObject js_object(JSObject::FindJSObject(context_ref, function_ref));
-      *exception = static_cast<JSValueRef>(CreateJSError("CallNamedFunction", function_name, js_object, e));
+      *exception = static_cast<JSValueRef>(CreateJSError("CallNamedFunction", function_property_callback.get_name(), js_object, e));
       return nullptr;
     }
 
@@ -370,52 +449,59 @@ namespace HAL { namespace detail {
   }
 
   template<typename T>
-  JSValue JSExportClass<T>::CreateJSError(const std::string& function_name, const std::string& location, JSObject js_source, const js_runtime_error& e) {
+  JSValue JSExportClass<T>::CreateJSError(const std::string& function_name, const std::string& location, const JSObject& js_source, const js_runtime_error& e) {
+    using namespace literals;
     const auto js_context = js_source.get_context();
     const auto name = GetJSExportComponentName(function_name, location);
 
     HAL_LOG_ERROR(name, ": ", e.what());
 
-    std::vector<JSValue> js_stack = e.js_stack();
-    js_stack.push_back(js_context.CreateString(name));
-
-    auto js_error = js_context.CreateError();
-    js_error.SetProperty("message",    js_context.CreateString(e.js_message()));
-    js_error.SetProperty("name",       js_context.CreateString(e.js_name()));
-    js_error.SetProperty("fileName",   js_context.CreateString(e.js_filename()));
-    js_error.SetProperty("native_stack",      js_context.CreateArray(js_stack));
-    js_error.SetProperty("lineNumber", js_context.CreateNumber(e.js_linenumber()));
+    // Copy the exception's stack into a new JavaScript array and
+    // append this callback to the array.
+    const auto& js_stack = e.get_js_stack();
+    auto native_stack = js_context.CreateArray(js_stack);
+    native_stack.SetProperty(static_cast<unsigned>(js_stack.size()), js_context.CreateString(name));
+
+    // The message is passed to the Error constructor, and the property
+    // names are interned, so the remaining properties are set with one
+    // call.
+    auto js_error = js_context.CreateError({ js_context.CreateString(e.js_message()) });
+    js_error.SetProperties({
+      { "name"_js        , js_context.CreateString(e.js_name())       },
+      { "fileName"_js    , js_context.CreateString(e.js_filename())   },
+      { "native_stack"_js, native_stack                               },
+      { "lineNumber"_js  , js_context.CreateNumber(e.js_linenumber()) }
+    });
     return js_error;
   }
 
   template<typename T>
-  JSValue JSExportClass<T>::CreateJSError(const std::string& function_name, JSObject js_source, const std::exception& e) {
+  JSValue JSExportClass<T>::CreateJSError(const std::string& function_name, const JSObject& js_source, const std::exception& e) {
     return CreateJSError(function_name, js_source, e.what());
   }
 
   template<typename T>
-  JSValue JSExportClass<T>::CreateJSError(const std::string& function_name, JSObject js_source, const std::string& what) {
+  JSValue JSExportClass<T>::CreateJSError(const std::string& function_name, const JSObject& js_source, const std::string& what) {
     const auto js_context = js_source.get_context();
     const auto name = GetJSExportComponentName(function_name);
 
     HAL_LOG_ERROR(name, ": ", what);
 
-    auto js_error = js_context.CreateError();
-    js_error.SetProperty("message",    js_context.CreateString(what));
-    js_error.SetProperty("native_stack",      js_context.CreateArray({ js_context.CreateString(name) }));
+    using namespace literals;
+    auto js_error = js_context.CreateError({ js_context.CreateString(what) });
+    js_error.SetProperty("native_stack"_js, js_context.CreateArray({ js_context.CreateString(name) }));
     return js_error;
   }
   
   template<typename T>
-  bool JSExportClass<T>::JSObjectHasPropertyCallback(JSContextRef context_ref, JSObjectRef object_ref, JSStringRef property_name_ref) try {
+  bool JSExportClass<T>::JSObjectHasPropertyCallback(JSContextRef, JSObjectRef object_ref, JSStringRef property_name_ref) try {
     
-    JSObject js_object(JSObject::FindJSObject(context_ref, object_ref));
     JSString property_name(property_name_ref);
     
-    auto       callback       = js_export_class_definition__.has_property_callback__;
+    auto       callback       = js_export_class_definition__ -> has_property_callback__;
     const bool callback_found = callback != nullptr;
 
-    const auto native_object_ptr = static_cast<const T*>(js_object.GetPrivate());
+    const auto native_object_ptr = static_cast<const T*>(JSObjectGetPrivate(object_ref));
     HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::HasProperty: callback found = ", callback_found, " for this[", native_object_ptr, "].", static_cast<std::string>(property_name));
     
     // precondition
@@ -438,13 +524,12 @@ namespace HAL { namespace detail {
   template<typename T>
   JSValueRef JSExportClass<T>::JSObjectGetPropertyCallback(JSContextRef context_ref, JSObjectRef object_ref, JSStringRef property_name_ref, JSValueRef* exception) try {
     
-    JSObject js_object(JSObject::FindJSObject(context_ref, object_ref));
     JSString property_name(property_name_ref);
     
-    auto       callback       = js_export_class_definition__.get_property_callback__;
+    auto       callback       = js_export_class_definition__ -> get_property_callback__;
     const bool callback_found = callback != nullptr;
     
-    const auto native_object_ptr = static_cast<const T*>(js_object.GetPrivate());
+    const auto native_object_ptr = static_cast<const T*>(JSObjectGetPrivate(object_ref));
     HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::GetProperty: callback found = ", callback_found, " for this[", native_object_ptr, "].", static_cast<std::string>(property_name));
     
     // precondition
@@ -486,20 +571,21 @@ namespace HAL { namespace detail {
   template<typename T>
   bool JSExportClass<T>::JSObjectSetPropertyCallback(JSContextRef context_ref, JSObjectRef object_ref, JSStringRef property_name_ref, JSValueRef value_ref, JSValueRef* exception) try {
     
-    JSObject js_object(JSObject::FindJSObject(context_ref, object_ref));
     JSString property_name(property_name_ref);
     
-    auto       callback       = js_export_class_definition__.set_property_callback__;
+    auto       callback       = js_export_class_definition__ -> set_property_callback__;
     const bool callback_found = callback != nullptr;
     
-    auto native_object_ptr = static_cast<T*>(js_object.GetPrivate());
+    const JSContextView js_context_view(context_ref);
+    
+    auto native_object_ptr = static_cast<T*>(JSObjectGetPrivate(object_ref));
     HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::SetProperty: callback found = ", callback_found, " for this[", native_object_ptr, "].", static_cast<std::string>(property_name));
     
     // precondition
     assert(callback_found);
     
     try {
-      const auto result = callback(*native_object_ptr, property_name, JSValue(js_object.get_context(), value_ref));
+      const auto result = callback(*native_object_ptr, property_name, JSValue(js_context_view.Promote(), value_ref));
       HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::SetProperty: result = ", result, " for this[", native_object_ptr, "].", static_cast<std::string>(property_name));
       return result;
     } catch (const js_runtime_error& e) {
@@ -521,13 +607,12 @@ namespace HAL { namespace detail {
   template<typename T>
   bool JSExportClass<T>::JSObjectDeletePropertyCallback(JSContextRef context_ref, JSObjectRef object_ref, JSStringRef property_name_ref, JSValueRef* exception) try {
     
-    JSObject js_object(JSObject::FindJSObject(context_ref, object_ref));
     JSString property_name(property_name_ref);
     
-    auto       callback       = js_export_class_definition__.delete_property_callback__;
+    auto       callback       = js_export_class_definition__ -> delete_property_callback__;
     const bool callback_found = callback != nullptr;
     
-    auto native_object_ptr = static_cast<T*>(js_object.GetPrivate());
+    auto native_object_ptr = static_cast<T*>(JSObjectGetPrivate(object_ref));
     HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::DeleteProperty: callback found = ", callback_found, " for this[", native_object_ptr, "].", static_cast<std::string>(property_name));
     
     // precondition
@@ -554,15 +639,14 @@ namespace HAL { namespace detail {
   }
   
   template<typename T>
-  void JSExportClass<T>::JSObjectGetPropertyNamesCallback(JSContextRef context_ref, JSObjectRef object_ref, JSPropertyNameAccumulatorRef property_names) try {
+  void JSExportClass<T>::JSObjectGetPropertyNamesCallback(JSContextRef, JSObjectRef object_ref, JSPropertyNameAccumulatorRef property_names) try {
     
-    JSObject                  js_object(JSObject::FindJSObject(context_ref, object_ref));
     JSPropertyNameAccumulator js_property_name_accumulator(property_names);
     
-    auto       callback       = js_export_class_definition__.get_property_names_callback__;
+    auto       callback       = js_export_class_definition__ -> get_property_names_callback__;
     const bool callback_found = callback != nullptr;
     
-    auto native_object_ptr = static_cast<T*>(js_object.GetPrivate());
+    auto native_object_ptr = static_cast<T*>(JSObjectGetPrivate(object_ref));
     HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::GetPropertyNames: callback found = ", callback_found, " for this[", native_object_ptr, "]");
     
     // precondition
@@ -585,7 +669,7 @@ namespace HAL { namespace detail {
     // precondition
     assert(js_object.IsFunction());
     
-    auto       callback       = js_export_class_definition__.call_as_function_callback__;
+    auto       callback       = js_export_class_definition__ -> call_as_function_callback__;
     const bool callback_found = callback != nullptr;
     
     auto native_object_ptr = static_cast<T*>(js_object.GetPrivate());
@@ -644,14 +728,11 @@ namespace HAL { namespace detail {
   
   template<typename T>
   bool JSExportClass<T>::JSObjectHasInstanceCallback(JSContextRef context_ref, JSObjectRef constructor_ref, JSValueRef possible_instance_ref, JSValueRef* exception) try {
-    JSObject js_object(JSObject::FindJSObject(context_ref, constructor_ref));
-    JSValue  possible_instance(js_object.get_context(), possible_instance_ref);
-
     bool result = false;
-    if (possible_instance.IsObject()) {
-      JSObject possible_object = static_cast<JSObject>(possible_instance);
-      if (possible_object.GetPrivate() != nullptr) {
-        auto possible_js_export_ptr     = static_cast<JSExport<T>*>(possible_object.GetPrivate());
+    if (JSValueIsObject(context_ref, possible_instance_ref)) {
+      const auto possible_private_ptr = JSObjectGetPrivate(JSValueToObject(context_ref, possible_instance_ref, nullptr));
+      if (possible_private_ptr != nullptr) {
+        auto possible_js_export_ptr     = static_cast<JSExport<T>*>(possible_private_ptr);
         auto possible_native_object_ptr = dynamic_cast<T*>(possible_js_export_ptr);
         if (possible_native_object_ptr != nullptr) {
           result = true;
@@ -659,9 +740,9 @@ namespace HAL { namespace detail {
       }
     }
     
-    auto native_object_ptr = static_cast<T*>(js_object.GetPrivate());
+    auto native_object_ptr = static_cast<T*>(JSObjectGetPrivate(constructor_ref));
     static_cast<void>(native_object_ptr);
-    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::HasInstance: result = ", result, " for ", to_string(possible_instance), " instanceof this[", native_object_ptr, "]");
+    HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::HasInstance: result = ", result, " for ", possible_instance_ref, " instanceof this[", native_object_ptr, "]");
     return result;
     
   } catch (const js_runtime_error& e) {
@@ -680,13 +761,12 @@ namespace HAL { namespace detail {
   
   template<typename T>
   JSValueRef JSExportClass<T>::JSObjectConvertToTypeCallback(JSContextRef context_ref, JSObjectRef object_ref, JSType type, JSValueRef* exception) try {
-    JSObject js_object(JSObject::FindJSObject(context_ref, object_ref));
     JSValue::Type js_value_type = ToJSValueType(type);
     
-    auto       callback       = js_export_class_definition__.convert_to_type_callback__;
+    auto       callback       = js_export_class_definition__ -> convert_to_type_callback__;
     const bool callback_found = callback != nullptr;
     
-    const auto native_object_ptr = static_cast<const T*>(js_object.GetPrivate());
+    const auto native_object_ptr = static_cast<const T*>(JSObjectGetPrivate(object_ref));
     HAL_LOG_DEBUG("JSExportClass<", typeid(T).name(), ">::ConvertToType: callback found = ", callback_found, " for this[", native_object_ptr, "]");
     
     // precondition
@@ -17,8 +17,10 @@
 #include "HAL/detail/JSExportNamedFunctionPropertyCallback.hpp"
 #include "HAL/detail/JSExportCallbacks.hpp"
 
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace HAL { namespace detail {
   
@@ -42,7 +44,10 @@ namespace HAL { namespace detail {
    derived from JSExport.
    
    The only way to create a JSExportClassDefinition is by using a
-   JSExportClassDefinitionBuilder.
+   JSExportClassDefinitionBuilder, which returns it frozen: it can't
+   be copied, moved or modified, and it is shared by pointer. Its
+   static values and static functions are built exactly once, when
+   the builder creates it.
    
    This class is thread safe and immutable by design.
    */
@@ -51,13 +56,12 @@ namespace HAL { namespace detail {
   public:
     
     JSExportClassDefinition(const JSExportClassDefinitionBuilder<T>& builder);
-    JSExportClassDefinition()                                          = default;
     ~JSExportClassDefinition()                                         = default;
-    JSExportClassDefinition(const JSExportClassDefinition&)            HAL_NOEXCEPT;
-    JSExportClassDefinition(JSExportClassDefinition&&)                 HAL_NOEXCEPT;
-    JSExportClassDefinition& operator=(const JSExportClassDefinition&) HAL_NOEXCEPT;
-    JSExportClassDefinition& operator=(JSExportClassDefinition&&)      HAL_NOEXCEPT;
-    void swap(JSExportClassDefinition&)                                HAL_NOEXCEPT;
+    JSExportClassDefinition()                                          = delete;
+    JSExportClassDefinition(const JSExportClassDefinition&)            = delete;
+    JSExportClassDefinition(JSExportClassDefinition&&)                 = delete;
+    JSExportClassDefinition& operator=(const JSExportClassDefinition&) = delete;
+    JSExportClassDefinition& operator=(JSExportClassDefinition&&)      = delete;
     
   private:
     
@@ -67,151 +71,76 @@ namespace HAL { namespace detail {
     template<typename U>
     friend class JSExportClass;
     
-    JSExportNamedValuePropertyCallbackMap_t<T>    named_value_property_callback_map__;
-    JSExportNamedFunctionPropertyCallbackMap_t<T> named_function_property_callback_map__;
-    HasPropertyCallback<T>                        has_property_callback__        { nullptr };
-    GetPropertyCallback<T>                        get_property_callback__        { nullptr };
-    SetPropertyCallback<T>                        set_property_callback__        { nullptr };
-    DeletePropertyCallback<T>                     delete_property_callback__     { nullptr };
-    GetPropertyNamesCallback<T>                   get_property_names_callback__  { nullptr };
-    CallAsFunctionCallback<T>                     call_as_function_callback__    { nullptr };
-    ConvertToTypeCallback<T>                      convert_to_type_callback__     { nullptr };
+    const JSExportNamedValuePropertyCallbackMap_t<T>    named_value_property_callback_map__;
+    const JSExportNamedFunctionPropertyCallbackMap_t<T> named_function_property_callback_map__;
+    
+    // The named function callbacks in the order of staticFunctions, so
+    // that JSExportClass<T>::CallNamedFunctionCallbackAt<I> can find
+    // the I-th one without a lookup. They point into
+    // named_function_property_callback_map__, which never changes.
+    std::vector<const JSExportNamedFunctionPropertyCallback<T>*> named_function_property_callbacks__;
+    
+    const HasPropertyCallback<T>                        has_property_callback__;
+    const GetPropertyCallback<T>                        get_property_callback__;
+    const SetPropertyCallback<T>                        set_property_callback__;
+    const DeletePropertyCallback<T>                     delete_property_callback__;
+    const GetPropertyNamesCallback<T>                   get_property_names_callback__;
+    const CallAsFunctionCallback<T>                     call_as_function_callback__;
+    const ConvertToTypeCallback<T>                      convert_to_type_callback__;
   };
   
+  // A frozen JSExportClassDefinition, as returned by
+  // JSExportClassDefinitionBuilder::build().
   template<typename T>
-  JSExportClassDefinition<T>::JSExportClassDefinition(const JSExportClassDefinition<T>& rhs) HAL_NOEXCEPT
-  : JSClassDefinition(rhs)
-  , named_value_property_callback_map__(rhs.named_value_property_callback_map__)
-  , named_function_property_callback_map__(rhs.named_function_property_callback_map__)
-  , has_property_callback__(rhs.has_property_callback__)
-  , get_property_callback__(rhs.get_property_callback__)
-  , set_property_callback__(rhs.set_property_callback__)
-  , delete_property_callback__(rhs.delete_property_callback__)
-  , get_property_names_callback__(rhs.get_property_names_callback__)
-  , call_as_function_callback__(rhs.call_as_function_callback__)
-  , convert_to_type_callback__(rhs.convert_to_type_callback__) {
-    InitializeNamedPropertyCallbacks();
-    
-//    std::clog << "MDL: copy ctor" << std::endl;
-//    Print();
-  }
+  using JSExportClassDefinitionPtr_t = std::shared_ptr<const JSExportClassDefinition<T>>;
   
   template<typename T>
-  JSExportClassDefinition<T>::JSExportClassDefinition(JSExportClassDefinition<T>&& rhs) HAL_NOEXCEPT
-  : JSClassDefinition(rhs)
-  , named_value_property_callback_map__(std::move(rhs.named_value_property_callback_map__))
-  , named_function_property_callback_map__(std::move(rhs.named_function_property_callback_map__))
-  , has_property_callback__(std::move(rhs.has_property_callback__))
-  , get_property_callback__(std::move(rhs.get_property_callback__))
-  , set_property_callback__(std::move(rhs.set_property_callback__))
-  , delete_property_callback__(std::move(rhs.delete_property_callback__))
-  , get_property_names_callback__(std::move(rhs.get_property_names_callback__))
-  , call_as_function_callback__(std::move(rhs.call_as_function_callback__))
-  , convert_to_type_callback__(std::move(rhs.convert_to_type_callback__)) {
-    InitializeNamedPropertyCallbacks();
-    
-//    std::clog << "MDL: move ctor" << std::endl;
-//    Print();
-  }
-  
-  template<typename T>
-  JSExportClassDefinition<T>& JSExportClassDefinition<T>::operator=(const JSExportClassDefinition<T>& rhs) HAL_NOEXCEPT {
-    HAL_JSCLASSDEFINITION_LOCK_GUARD;
-    JSClassDefinition::operator=(rhs);
-    named_value_property_callback_map__    = rhs.named_value_property_callback_map__;
-    named_function_property_callback_map__ = rhs.named_function_property_callback_map__;
-    has_property_callback__                = rhs.has_property_callback__;
-    get_property_callback__                = rhs.get_property_callback__;
-    set_property_callback__                = rhs.set_property_callback__;
-    delete_property_callback__             = rhs.delete_property_callback__;
-    get_property_names_callback__          = rhs.get_property_names_callback__;
-    call_as_function_callback__            = rhs.call_as_function_callback__;
-    convert_to_type_callback__             = rhs.convert_to_type_callback__;
-    InitializeNamedPropertyCallbacks();
-    
-//    std::clog << "MDL: copy assignment" << std::endl;
-//    Print();
-    
-    return *this;
-    }
+  void JSExportClassDefinition<T>::InitializeNamedPropertyCallbacks() HAL_NOEXCEPT {
     
-    template<typename T>
-    JSExportClassDefinition<T>& JSExportClassDefinition<T>::operator=(JSExportClassDefinition<T>&& rhs) HAL_NOEXCEPT {
-      HAL_JSCLASSDEFINITION_LOCK_GUARD;
-      swap(rhs);
-      InitializeNamedPropertyCallbacks();
-      
-//      std::clog << "MDL: move assignment" << std::endl;
-//      Print();
-      
-      return *this;
-    }
-    
-    template<typename T>
-    void JSExportClassDefinition<T>::swap(JSExportClassDefinition<T>& other) HAL_NOEXCEPT {
-      HAL_JSCLASSDEFINITION_LOCK_GUARD;
-      JSClassDefinition::swap(other);
-      using std::swap;
-      
-      // By swapping the members of two classes, the two classes are
-      // effectively swapped.
-      swap(named_value_property_callback_map__   , other.named_value_property_callback_map__);
-      swap(named_function_property_callback_map__, other.named_function_property_callback_map__);
-      swap(has_property_callback__               , other.has_property_callback__);
-      swap(get_property_callback__               , other.get_property_callback__);
-      swap(set_property_callback__               , other.set_property_callback__);
-      swap(delete_property_callback__            , other.delete_property_callback__);
-      swap(get_property_names_callback__         , other.get_property_names_callback__);
-      swap(call_as_function_callback__           , other.call_as_function_callback__);
-      swap(convert_to_type_callback__            , other.convert_to_type_callback__);
-    }
-    
-    template<typename T>
-    void swap(JSExportClassDefinition<T>& first, JSExportClassDefinition<T>& second) HAL_NOEXCEPT {
-      first.swap(second);
+    // Initialize staticValues. This runs once per definition, in the
+    // constructor, so the vectors are sized exactly.
+    static_values__.clear();
+    static_values__.reserve(named_value_property_callback_map__.size() + 1);
+    js_class_definition__.staticValues = nullptr;
+    if (!named_value_property_callback_map__.empty()) {
+      for (const auto& entry : named_value_property_callback_map__) {
+        const auto& property_name       = entry.first;
+        const auto  property_attributes = entry.second.get_property_attributes();
+        ::JSStaticValue static_value;
+        static_value.name        = property_name.c_str();
+        static_value.getProperty = JSExportClass<T>::GetNamedValuePropertyCallback;
+        static_value.setProperty = JSExportClass<T>::SetNamedValuePropertyCallback;
+        static_value.attributes  = static_cast<::JSPropertyAttributes>(property_attributes);
+        static_values__.push_back(static_value);
+        // HAL_LOG_DEBUG("JSExportClassDefinition<", name__, "> added value property ", static_values__.back().name);
+      }
+      static_values__.push_back({nullptr, nullptr, nullptr, kJSPropertyAttributeNone});
+      js_class_definition__.staticValues = &static_values__[0];
     }
     
-    template<typename T>
-    void JSExportClassDefinition<T>::InitializeNamedPropertyCallbacks() HAL_NOEXCEPT {
-      
-      // Initialize staticValues.
-      static_values__.clear();
-      js_class_definition__.staticValues = nullptr;
-      if (!named_value_property_callback_map__.empty()) {
-        for (const auto& entry : named_value_property_callback_map__) {
-          const auto& property_name       = entry.first;
-          const auto& property_attributes = entry.second.get_attributes();
-          ::JSStaticValue static_value;
-          static_value.name        = property_name.c_str();
-          static_value.getProperty = JSExportClass<T>::GetNamedValuePropertyCallback;
-          static_value.setProperty = JSExportClass<T>::SetNamedValuePropertyCallback;
-          static_value.attributes  = ToJSPropertyAttributes(property_attributes);
-          static_values__.push_back(static_value);
-          // HAL_LOG_DEBUG("JSExportClassDefinition<", name__, "> added value property ", static_values__.back().name);
-        }
-        static_values__.push_back({nullptr, nullptr, nullptr, kJSPropertyAttributeNone});
-        js_class_definition__.staticValues = &static_values__[0];
-      }
-      
-      // Initialize staticFunctions.
-      static_functions__.clear();
-      js_class_definition__.staticFunctions = nullptr;
-      if (!named_function_property_callback_map__.empty()) {
-        for (const auto& entry : named_function_property_callback_map__) {
-          const auto& function_name = entry.first;
-          const auto& property_attributes = entry.second.get_attributes();
-          ::JSStaticFunction static_function;
-          static_function.name           = function_name.c_str();
-          static_function.callAsFunction = JSExportClass<T>::CallNamedFunctionCallback;
-          static_function.attributes     = ToJSPropertyAttributes(property_attributes);
-          static_functions__.push_back(static_function);
-          // HAL_LOG_DEBUG("JSExportClassDefinition<", name__, "> added function property ", static_functions__.back().name);
-        }
-        static_functions__.push_back({nullptr, nullptr, kJSPropertyAttributeNone});
-        js_class_definition__.staticFunctions = &static_functions__[0];
+    // Initialize staticFunctions.
+    static_functions__.clear();
+    static_functions__.reserve(named_function_property_callback_map__.size() + 1);
+    named_function_property_callbacks__.clear();
+    named_function_property_callbacks__.reserve(named_function_property_callback_map__.size());
+    js_class_definition__.staticFunctions = nullptr;
+    if (!named_function_property_callback_map__.empty()) {
+      for (const auto& entry : named_function_property_callback_map__) {
+        const auto& function_name       = entry.first;
+        const auto  property_attributes = entry.second.get_property_attributes();
+        ::JSStaticFunction static_function;
+        static_function.name           = function_name.c_str();
+        static_function.callAsFunction = JSExportClass<T>::GetCallNamedFunctionCallback(named_function_property_callbacks__.size());
+        static_function.attributes     = static_cast<::JSPropertyAttributes>(property_attributes);
+        static_functions__.push_back(static_function);
+        named_function_property_callbacks__.push_back(&entry.second);
+        // HAL_LOG_DEBUG("JSExportClassDefinition<", name__, "> added function property ", static_functions__.back().name);
       }
+      static_functions__.push_back({nullptr, nullptr, kJSPropertyAttributeNone});
+      js_class_definition__.staticFunctions = &static_functions__[0];
     }
-    
-    }} // namespace HAL { namespace detail {
-    
+  }
+  
+}} // namespace HAL { namespace detail {
+
 #endif // _HAL_DETAIL_JSEXPORTCLASSDEFINITION_HPP_
@@ -17,17 +17,6 @@
 #include <string>
 #include <cstdint>
 
-#undef HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_MUTEX
-#undef HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD
-#ifdef HAL_THREAD_SAFE
-#define HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_MUTEX                      std::recursive_mutex       mutex__
-#define HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock(mutex__)
-#else
-#define HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_MUTEX
-#define HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD
-#endif  // HAL_THREAD_SAFE
-
-
 namespace HAL { namespace detail {
   
   /*!
@@ -117,7 +106,6 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& ClassName(const std::string& class_name) {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
       if (class_name.empty()) {
         ThrowInvalidArgument("JSExportClassDefinitionBuilder::ClassName", "The class name cannot be emoty.");
       }
@@ -145,7 +133,6 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& Version(std::uint32_t class_version) HAL_NOEXCEPT {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
       js_class_definition__.version = class_version;
       return *this;
     }
@@ -153,24 +140,24 @@ namespace HAL { namespace detail {
     /*!
      @method
      
-     @abstract Return your JSClass's JSClassAttribute.
+     @abstract Return your JSClass's JSClassAttributes.
      
-     @result Your JSClass's JSClassAttribute.
+     @result Your JSClass's JSClassAttributes.
      */
-    JSClassAttribute ClassAttribute() const HAL_NOEXCEPT {
-      return FromJSClassAttributes(js_class_definition__.attributes);
+    JSClassAttributes ClassAttribute() const HAL_NOEXCEPT {
+      return JSClassAttributes(js_class_definition__.attributes);
     }
     
     /*!
      @method
      
-     @abstract Set your JSClass's JSClassAttribute.
+     @abstract Set your JSClass's JSClassAttributes. A single
+     JSClassAttribute may also be given.
      
      @result A reference to the builder for chaining.
      */
-    JSExportClassDefinitionBuilder<T>& ClassAttribute(JSClassAttribute class_attribute) HAL_NOEXCEPT {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
-      js_class_definition__.attributes = ToJSClassAttribute(class_attribute);
+    JSExportClassDefinitionBuilder<T>& ClassAttribute(JSClassAttributes class_attributes) HAL_NOEXCEPT {
+      js_class_definition__.attributes = static_cast<::JSClassAttributes>(class_attributes);
       return *this;
     }
     
@@ -195,7 +182,6 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& Parent(const JSClass& parent) HAL_NOEXCEPT {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
       parent__ = parent;
       return *this;
     }
@@ -251,10 +237,13 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& AddValueProperty(const JSString& property_name, GetNamedValuePropertyCallback<T> get_callback, SetNamedValuePropertyCallback<T> set_callback = nullptr, bool enumerable = true) {
-      std::unordered_set<JSPropertyAttribute> attributes { JSPropertyAttribute::DontDelete };
-      static_cast<void>(!enumerable   && attributes.insert(JSPropertyAttribute::DontEnum).second);
-      static_cast<void>(!set_callback && attributes.insert(JSPropertyAttribute::ReadOnly).second);
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
+      JSPropertyAttributes attributes = JSPropertyAttribute::DontDelete;
+      if (!enumerable) {
+        attributes |= JSPropertyAttribute::DontEnum;
+      }
+      if (!set_callback) {
+        attributes |= JSPropertyAttribute::ReadOnly;
+      }
       AddValuePropertyCallback(JSExportNamedValuePropertyCallback<T>(property_name, get_callback, set_callback, attributes));
       return *this;
     }
@@ -292,9 +281,10 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& AddFunctionProperty(const JSString& function_name, CallNamedFunctionCallback<T> function_callback, bool enumerable = true) {
-      std::unordered_set<JSPropertyAttribute> attributes { JSPropertyAttribute::DontDelete, JSPropertyAttribute::ReadOnly };
-      static_cast<void>(!enumerable && attributes.insert(JSPropertyAttribute::DontEnum).second);
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
+      JSPropertyAttributes attributes = JSPropertyAttribute::DontDelete | JSPropertyAttribute::ReadOnly;
+      if (!enumerable) {
+        attributes |= JSPropertyAttribute::DontEnum;
+      }
       AddFunctionPropertyCallback(JSExportNamedFunctionPropertyCallback<T>(function_name, function_callback, attributes));
       return *this;
     }
@@ -347,7 +337,6 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& HasProperty(const HasPropertyCallback<T>& has_property_callback) HAL_NOEXCEPT {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
       has_property_callback__ = has_property_callback;
       return *this;
     }
@@ -391,7 +380,6 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& GetProperty(const GetPropertyCallback<T>& get_property_callback) HAL_NOEXCEPT {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
       get_property_callback__ = get_property_callback;
       return *this;
     }
@@ -435,7 +423,6 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& SetProperty(const SetPropertyCallback<T>& set_property_callback) HAL_NOEXCEPT {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
       set_property_callback__ = set_property_callback;
       return *this;
     }
@@ -479,7 +466,6 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& DeleteProperty(const DeletePropertyCallback<T>& delete_property_callback) HAL_NOEXCEPT {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
       delete_property_callback__ = delete_property_callback;
       return *this;
     }
@@ -528,7 +514,6 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& GetPropertyNames(const GetPropertyNamesCallback<T>& get_property_names_callback) HAL_NOEXCEPT {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
       get_property_names_callback__ = get_property_names_callback;
       return *this;
     }
@@ -575,7 +560,6 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& CallAsFunction(const CallAsFunctionCallback<T>& call_as_function_callback) HAL_NOEXCEPT {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
       call_as_function_callback__ = call_as_function_callback;
       return *this;
     }
@@ -620,7 +604,6 @@ namespace HAL { namespace detail {
      @result A reference to the builder for chaining.
      */
     JSExportClassDefinitionBuilder<T>& ConvertToType(const ConvertToTypeCallback<T>& convert_to_type_callback) HAL_NOEXCEPT {
-      HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
       convert_to_type_callback__ = convert_to_type_callback;
       return *this;
     }
@@ -628,13 +611,14 @@ namespace HAL { namespace detail {
     /*!
      @method
      
-     @abstract Create and return a JSClass instance with all of the
-     properties and callbacks specified in this builder.
+     @abstract Create and return a frozen JSExportClassDefinition with
+     all of the properties and callbacks specified in this builder.
      
-     @result A JSClass instance with all of the properties and
-     callbacks specified in this builder.
+     @result A shared pointer to an immutable JSExportClassDefinition
+     with all of the properties and callbacks specified in this
+     builder.
      */
-    JSExportClassDefinition<T> build();
+    JSExportClassDefinitionPtr_t<T> build();
     
   private:
     
@@ -658,8 +642,6 @@ namespace HAL { namespace detail {
     GetPropertyNamesCallback<T>                   get_property_names_callback__  { nullptr };
     CallAsFunctionCallback<T>                     call_as_function_callback__    { nullptr };
     ConvertToTypeCallback<T>                      convert_to_type_callback__     { nullptr };
-    
-    HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_MUTEX;
   };
   
   template<typename T>
@@ -701,8 +683,7 @@ namespace HAL { namespace detail {
   }
   
   template<typename T>
-  JSExportClassDefinition<T> JSExportClassDefinitionBuilder<T>::build() {
-    HAL_DETAIL_JSEXPORTCLASSDEFINITIONBUILDER_LOCK_GUARD;
+  JSExportClassDefinitionPtr_t<T> JSExportClassDefinitionBuilder<T>::build() {
     const std::string internal_component_name = "JSExportClassDefinitionBuilder<" + name__ + ">::build()";
     
     js_class_definition__.className         = name__.c_str();
@@ -740,7 +721,7 @@ namespace HAL { namespace detail {
       js_class_definition__.convertToType = JSExportClass<T>::JSObjectConvertToTypeCallback;
     }
     
-    return JSExportClassDefinition<T>(*this);
+    return std::make_shared<const JSExportClassDefinition<T>>(*this);
   }
   
   template<typename T>
@@ -56,7 +56,7 @@ namespace HAL { namespace detail {
      @param function_callback The callback to invoke when calling
      the JavaScript object as a function.
      
-     @param attributes The set of JSPropertyAttributes to give to
+     @param attributes The JSPropertyAttributes to give to
      the function property.
      
      @result The callback to invoke when a JavaScript object is
@@ -71,9 +71,9 @@ namespace HAL { namespace detail {
      */
     JSExportNamedFunctionPropertyCallback(const std::string& function_name,
                                           CallNamedFunctionCallback<T> function_callback,
-                                          const std::unordered_set<JSPropertyAttribute>& attributes);
+                                          JSPropertyAttributes attributes);
     
-    CallNamedFunctionCallback<T> function_callback() const {
+    const CallNamedFunctionCallback<T>& function_callback() const HAL_NOEXCEPT {
       return function_callback__;
     }
     
@@ -96,8 +96,8 @@ namespace HAL { namespace detail {
   JSExportNamedFunctionPropertyCallback<T>::JSExportNamedFunctionPropertyCallback(
                                                                                   const std::string& function_name,
                                                                                   CallNamedFunctionCallback<T> function_callback,
-                                                                                  const std::unordered_set<JSPropertyAttribute>& attributes)
-  : JSPropertyCallback(function_name, attributes)
+                                                                                  JSPropertyAttributes attributes)
+  : JSPropertyCallback(function_name, attributes.to_unordered_set())
   , function_callback__(function_callback) {
     
     if (!function_callback) {
@@ -119,7 +119,6 @@ namespace HAL { namespace detail {
   
   template<typename T>
   JSExportNamedFunctionPropertyCallback<T>& JSExportNamedFunctionPropertyCallback<T>::operator=(const JSExportNamedFunctionPropertyCallback<T>& rhs) HAL_NOEXCEPT {
-    HAL_DETAIL_JSPROPERTYCALLBACK_LOCK_GUARD;
     JSPropertyCallback::operator=(rhs);
     function_callback__ = rhs.function_callback__;
     return *this;
@@ -127,14 +126,12 @@ namespace HAL { namespace detail {
   
   template<typename T>
   JSExportNamedFunctionPropertyCallback<T>& JSExportNamedFunctionPropertyCallback<T>::operator=(JSExportNamedFunctionPropertyCallback<T>&& rhs) HAL_NOEXCEPT {
-    HAL_DETAIL_JSPROPERTYCALLBACK_LOCK_GUARD;
     swap(rhs);
     return *this;
   }
   
   template<typename T>
   void JSExportNamedFunctionPropertyCallback<T>::swap(JSExportNamedFunctionPropertyCallback<T>& other) HAL_NOEXCEPT {
-    HAL_DETAIL_JSPROPERTYCALLBACK_LOCK_GUARD;
     JSPropertyCallback::swap(other);
     using std::swap;
     
@@ -43,7 +43,7 @@ namespace HAL { namespace detail {
      property's value on a JavaScript object. This may be nullptr,
      in which case the ReadOnly attribute is automatically set.
      
-     @param attributes The set of JSPropertyAttributes to give to
+     @param attributes The JSPropertyAttributes to give to
      the value property.
      
      @result An object which describes a JavaScript value property.
@@ -64,7 +64,7 @@ namespace HAL { namespace detail {
     JSExportNamedValuePropertyCallback(const std::string& property_name,
                                        GetNamedValuePropertyCallback<T> get_callback,
                                        SetNamedValuePropertyCallback<T> set_callback,
-                                       const std::unordered_set<JSPropertyAttribute>& attributes);
+                                       JSPropertyAttributes attributes);
     
     GetNamedValuePropertyCallback<T> get_callback() const HAL_NOEXCEPT {
       return get_callback__;
@@ -95,8 +95,8 @@ namespace HAL { namespace detail {
                                                                             const std::string& property_name,
                                                                             GetNamedValuePropertyCallback<T> get_callback,
                                                                             SetNamedValuePropertyCallback<T> set_callback,
-                                                                            const std::unordered_set<JSPropertyAttribute>& attributes)
-  : JSPropertyCallback(property_name, attributes)
+                                                                            JSPropertyAttributes attributes)
+  : JSPropertyCallback(property_name, attributes.to_unordered_set())
   , get_callback__(get_callback)
   , set_callback__(set_callback) {
     
@@ -104,7 +104,7 @@ namespace HAL { namespace detail {
       ThrowInvalidArgument("JSExportNamedValuePropertyCallback", "Both get_callback and set_callback are missing. At least one callback must be provided");
     }
     
-    if (attributes.find(JSPropertyAttribute::ReadOnly) != attributes.end()) {
+    if (attributes.Has(JSPropertyAttribute::ReadOnly)) {
       if (!get_callback) {
         ThrowInvalidArgument("JSExportNamedValuePropertyCallback", "ReadOnly attribute is set but get_callback is missing");
       }
@@ -137,7 +137,6 @@ namespace HAL { namespace detail {
   
   template<typename T>
   JSExportNamedValuePropertyCallback<T>& JSExportNamedValuePropertyCallback<T>::operator=(const JSExportNamedValuePropertyCallback<T>& rhs) HAL_NOEXCEPT {
-    HAL_DETAIL_JSPROPERTYCALLBACK_LOCK_GUARD;
     JSPropertyCallback::operator=(rhs);
     get_callback__ = rhs.get_callback__;
     set_callback__ = rhs.set_callback__;
@@ -146,14 +145,12 @@ namespace HAL { namespace detail {
   
   template<typename T>
   JSExportNamedValuePropertyCallback<T>& JSExportNamedValuePropertyCallback<T>::operator=(JSExportNamedValuePropertyCallback<T>&& rhs) HAL_NOEXCEPT {
-    HAL_DETAIL_JSPROPERTYCALLBACK_LOCK_GUARD;
     swap(rhs);
     return *this;
   }
   
   template<typename T>
   void JSExportNamedValuePropertyCallback<T>::swap(JSExportNamedValuePropertyCallback<T>& other) HAL_NOEXCEPT {
-    HAL_DETAIL_JSPROPERTYCALLBACK_LOCK_GUARD;
     JSPropertyCallback::swap(other);
     using std::swap;
     
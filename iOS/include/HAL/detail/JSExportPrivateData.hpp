@@ -0,0 +1,217 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_DETAIL_JSEXPORTPRIVATEDATA_HPP_
+#define _HAL_DETAIL_JSEXPORTPRIVATEDATA_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/detail/JSLeakRegistry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace HAL { namespace detail {
+
+  // A compile-time type id for a C++ class exported with JSExport<T>:
+  // the address of a static that exists once per T.
+  using JSExportTypeId = const void*;
+
+  // The extra memory reported for the native objects of one class.
+  struct JSExportMemoryCounter final {
+
+    // The number of bytes reported for native objects that are still
+    // alive.
+    std::atomic<std::size_t> extra_memory_size     { 0 };
+
+    // The number of bytes ever reported.
+    std::atomic<std::size_t> extra_memory_reported { 0 };
+  };
+
+  template<typename T>
+  struct JSExportTypeInfo final {
+
+    static JSExportTypeId GetId() HAL_NOEXCEPT {
+      return &id;
+    }
+
+    static const char id;
+
+    // The JSClassRef of JSExportClass<T>, recorded when the class is
+    // created. It stays nullptr until then, in which case no JavaScript
+    // object has private data of type T.
+    static std::atomic<JSClassRef> js_class_ref;
+
+    static JSExportMemoryCounter memory_counter;
+  };
+
+  template<typename T>
+  const char JSExportTypeInfo<T>::id = 0;
+
+  template<typename T>
+  std::atomic<JSClassRef> JSExportTypeInfo<T>::js_class_ref { nullptr };
+
+  template<typename T>
+  JSExportMemoryCounter JSExportTypeInfo<T>::memory_counter;
+
+  /*!
+   @class
+
+   @discussion A JSExportPrivateDataHeader sits in the same allocation
+   immediately before every native object that a JSExportClass creates
+   for its JavaScript objects. The JavaScript object's private data
+   still points at the native object itself, so the header is found at
+   a fixed offset without a lookup.
+
+   The header records the native object's type id, so that
+   JSObject::GetPrivate<T> can return a T* without a dynamic_cast, and
+   the function that destroys it, so that the native object is always
+   destroyed as the type it was created as.
+
+   It also records how much extra memory was reported for the native
+   object, so that the total for its class goes down again when the
+   native object is destroyed. When a derived class' initialize
+   callback replaces the native object of a parent class, the bytes
+   the garbage collector was already told about for the parent's
+   object are carried over in inherited_extra_memory_size, and the
+   derived object's reports are charged against them first, so that
+   the same memory isn't reported twice.
+
+   Finally it points back at the native object's JavaScript object
+   and its JSContextGroup, for JSExport<T>::FindJSObject. The pointer
+   isn't a reference: it costs nothing and needs no JavaScriptCore
+   call. It is valid for as long as the native object, since the
+   JavaScript object's finalizer destroys the native object, and the
+   group is only compared, never used.
+   */
+  struct alignas(std::max_align_t) JSExportPrivateDataHeader final {
+
+    JSExportTypeId         type_id;
+    void                 (*destroy)(void* private_data);
+    JSExportMemoryCounter* memory_counter;
+    std::size_t            extra_memory_size;
+    std::size_t            inherited_extra_memory_size;
+    JSObjectRef            js_object_ref;
+    JSContextGroupRef      js_context_group_ref;
+
+    static const JSExportPrivateDataHeader* Get(const void* private_data) HAL_NOEXCEPT {
+      return static_cast<const JSExportPrivateDataHeader*>(private_data) - 1;
+    }
+
+    static JSExportPrivateDataHeader* Get(void* private_data) HAL_NOEXCEPT {
+      return static_cast<JSExportPrivateDataHeader*>(private_data) - 1;
+    }
+
+    // Add the given number of bytes held outside the JavaScript heap
+    // to the native object's total and its class' totals, and tell the
+    // garbage collector about those not already inherited from a
+    // parent class' native object. JavaScriptCore's public API has no
+    // way to tell the garbage collector, so that part needs
+    // HAL_PRIVATE_API_ENABLE.
+    static void ReportExtraMemory(JSContextRef js_context_ref, void* private_data, std::size_t bytes) HAL_NOEXCEPT {
+      if (bytes == 0) {
+        return;
+      }
+      const auto header = Get(private_data);
+      header -> extra_memory_size += bytes;
+      header -> memory_counter -> extra_memory_size     += bytes;
+      header -> memory_counter -> extra_memory_reported += bytes;
+      const auto inherited = std::min(bytes, header -> inherited_extra_memory_size);
+      header -> inherited_extra_memory_size -= inherited;
+#ifdef HAL_PRIVATE_API_ENABLE
+      if (bytes > inherited) {
+        JSReportExtraMemoryCost(js_context_ref, bytes - inherited);
+      }
+#else
+      static_cast<void>(js_context_ref);
+#endif
+    }
+
+    // Carry the extra memory the garbage collector was told about for
+    // a parent class' native object over to the native object of a
+    // derived class that replaces it.
+    static void InheritExtraMemory(void* private_data, const void* parent_private_data) HAL_NOEXCEPT {
+      const auto parent_header = Get(parent_private_data);
+      Get(private_data) -> inherited_extra_memory_size = parent_header -> extra_memory_size + parent_header -> inherited_extra_memory_size;
+    }
+
+    // Record the JavaScript object whose private data the native
+    // object is.
+    static void SetJSObject(void* private_data, JSContextRef js_context_ref, JSObjectRef js_object_ref) HAL_NOEXCEPT {
+      auto header = Get(private_data);
+      header -> js_object_ref        = js_object_ref;
+      header -> js_context_group_ref = JSContextGetGroup(js_context_ref);
+    }
+
+    // Return the native object's JavaScript object, or nullptr if it
+    // wasn't recorded yet.
+    static JSObjectRef GetJSObject(const void* private_data) HAL_NOEXCEPT {
+      return Get(private_data) -> js_object_ref;
+    }
+
+    // Destroy a native object created by JSExportPrivateData<T>::Create
+    // for any T.
+    static void Destroy(void* private_data) HAL_NOEXCEPT {
+      if (private_data) {
+        HAL_DETAIL_JSLEAKREGISTRY_UNTRACK(private_data);
+        const auto header = Get(private_data);
+        header -> memory_counter -> extra_memory_size -= header -> extra_memory_size;
+        header -> destroy(private_data);
+      }
+    }
+  };
+
+  template<typename T>
+  class JSExportPrivateData final {
+
+    static_assert(alignof(T) <= alignof(JSExportPrivateDataHeader), "A JSExport class can't be over-aligned");
+
+  public:
+
+    template<typename... Arguments>
+    static T* Create(Arguments&&... arguments) {
+      void* memory = ::operator new(sizeof(JSExportPrivateDataHeader) + sizeof(T));
+      auto  header = new (memory) JSExportPrivateDataHeader { JSExportTypeInfo<T>::GetId(), Destroy, &JSExportTypeInfo<T>::memory_counter, 0, 0, nullptr, nullptr };
+      try {
+        return new (header + 1) T(std::forward<Arguments>(arguments)...);
+      } catch (...) {
+        ::operator delete(memory);
+        throw;
+      }
+    }
+
+    // Return the given JavaScript object's private data if it was
+    // created by a JSExportClass whose class is T's class or inherits
+    // from it, otherwise nullptr.
+    static void* Find(JSContextRef js_context_ref, JSObjectRef js_object_ref) HAL_NOEXCEPT {
+      const JSClassRef js_class_ref = JSExportTypeInfo<T>::js_class_ref.load(std::memory_order_acquire);
+      if (js_class_ref == nullptr || !JSValueIsObjectOfClass(js_context_ref, js_object_ref, js_class_ref)) {
+        return nullptr;
+      }
+      return JSObjectGetPrivate(js_object_ref);
+    }
+
+    // Return true if the given private data, as returned by Find, was
+    // created as a T.
+    static bool IsExactly(const void* private_data) HAL_NOEXCEPT {
+      return JSExportPrivateDataHeader::Get(private_data) -> type_id == JSExportTypeInfo<T>::GetId();
+    }
+
+  private:
+
+    static void Destroy(void* private_data) HAL_NOEXCEPT {
+      static_cast<T*>(private_data) -> ~T();
+      ::operator delete(const_cast<JSExportPrivateDataHeader*>(JSExportPrivateDataHeader::Get(private_data)));
+    }
+  };
+
+}} // namespace HAL { namespace detail {
+
+#endif // _HAL_DETAIL_JSEXPORTPRIVATEDATA_HPP_
@@ -0,0 +1,158 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_DETAIL_JSLEAKREGISTRY_HPP_
+#define _HAL_DETAIL_JSLEAKREGISTRY_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+
+// Add -DHAL_LEAK_DETECTOR_ENABLE=1 to record every JSExport native
+// object for JSLeakDetector.
+#ifdef HAL_LEAK_DETECTOR_ENABLE
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__APPLE__) || defined(__GLIBC__)
+#include <execinfo.h>
+#define HAL_DETAIL_JSLEAKREGISTRY_BACKTRACE_ENABLE
+#endif
+
+namespace HAL { namespace detail {
+
+  // Where and as what a native object was created.
+  struct JSLeakRecord final {
+    const char*              class_name { nullptr };
+    JSContextGroupRef        js_context_group_ref { nullptr };
+    std::uint64_t            sequence { 0 };
+    std::array<void*, 16>    frames;
+    int                      frame_count { 0 };
+  };
+
+  /*!
+   @class
+
+   @discussion The JSLeakRegistry records every live JSExport native
+   object with its class name and the backtrace of its creation. It
+   also remembers the most recently destroyed ones, so that a registry
+   entry that outlived its native object can still be traced to where
+   the object was created.
+
+   Untrack runs in a JavaScript object's finalizer, where an exception
+   can't be thrown, so it doesn't allocate: the destroyed records live
+   in a ring buffer allocated with the registry.
+
+   It is only compiled with HAL_LEAK_DETECTOR_ENABLE, and read by
+   JSLeakDetector.
+   */
+  class JSLeakRegistry final {
+
+  public:
+
+    static void Track(const void* private_data, const char* class_name, JSContextRef js_context_ref) {
+      JSLeakRecord record;
+      record.class_name           = class_name;
+      record.js_context_group_ref = js_context_ref ? JSContextGetGroup(js_context_ref) : nullptr;
+#ifdef HAL_DETAIL_JSLEAKREGISTRY_BACKTRACE_ENABLE
+      record.frame_count          = ::backtrace(record.frames.data(), static_cast<int>(record.frames.size()));
+#endif
+
+      auto& state = GetState();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      record.sequence = ++state.sequence;
+      state.live[private_data] = record;
+    }
+
+    static void Untrack(const void* private_data) HAL_NOEXCEPT {
+      auto& state = GetState();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      const auto position = state.live.find(private_data);
+      if (position == state.live.end()) {
+        return;
+      }
+      state.destroyed[state.destroyed_next] = std::make_pair(private_data, position -> second);
+      state.destroyed_next = (state.destroyed_next + 1) % kDestroyedCapacity;
+      state.live.erase(position);
+    }
+
+    // Return the live native objects, oldest first.
+    static std::vector<std::pair<const void*, JSLeakRecord>> GetLive() {
+      auto& state = GetState();
+      std::vector<std::pair<const void*, JSLeakRecord>> live;
+      {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        live.assign(state.live.begin(), state.live.end());
+      }
+      std::sort(live.begin(), live.end(), [](const std::pair<const void*, JSLeakRecord>& lhs, const std::pair<const void*, JSLeakRecord>& rhs) {
+        return lhs.second.sequence < rhs.second.sequence;
+      });
+      return live;
+    }
+
+    static bool IsLive(const void* private_data) {
+      auto& state = GetState();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      return state.live.count(private_data) > 0;
+    }
+
+    // Find the record of the native object most recently destroyed at
+    // the given address, if it was destroyed recently enough.
+    static bool FindDestroyed(const void* private_data, JSLeakRecord& record) {
+      auto& state = GetState();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      bool found = false;
+      for (const auto& entry : state.destroyed) {
+        if (entry.first == private_data && (!found || entry.second.sequence > record.sequence)) {
+          record = entry.second;
+          found  = true;
+        }
+      }
+      return found;
+    }
+
+  private:
+
+    static const std::size_t kDestroyedCapacity = 4096;
+
+    struct State final {
+
+      State()
+      : destroyed(kDestroyedCapacity) {
+      }
+
+      std::mutex                                        mutex;
+      std::uint64_t                                     sequence { 0 };
+      std::unordered_map<const void*, JSLeakRecord>     live;
+      std::vector<std::pair<const void*, JSLeakRecord>> destroyed;
+      std::size_t                                       destroyed_next { 0 };
+    };
+
+    // Never destroyed, so that native objects finalized during static
+    // destruction can still be untracked.
+    static State& GetState() {
+      static State* state = new State();
+      return *state;
+    }
+  };
+
+}} // namespace HAL { namespace detail {
+
+#define HAL_DETAIL_JSLEAKREGISTRY_TRACK(private_data, class_name, js_context_ref) HAL::detail::JSLeakRegistry::Track(private_data, class_name, js_context_ref)
+#define HAL_DETAIL_JSLEAKREGISTRY_UNTRACK(private_data) HAL::detail::JSLeakRegistry::Untrack(private_data)
+#else
+#define HAL_DETAIL_JSLEAKREGISTRY_TRACK(private_data, class_name, js_context_ref)
+#define HAL_DETAIL_JSLEAKREGISTRY_UNTRACK(private_data)
+#endif // HAL_LEAK_DETECTOR_ENABLE
+
+#endif // _HAL_DETAIL_JSLEAKREGISTRY_HPP_
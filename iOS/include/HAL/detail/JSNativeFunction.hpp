@@ -0,0 +1,184 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_DETAIL_JSNATIVEFUNCTION_HPP_
+#define _HAL_DETAIL_JSNATIVEFUNCTION_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSObject.hpp"
+#include "HAL/detail/JSValueConverter.hpp"
+#include "HAL/detail/JSStringRefHolder.hpp"
+
+#include <cstddef>
+#include <exception>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace HAL { namespace detail {
+
+  template<std::size_t... Indices>
+  struct JSIndexSequence {
+  };
+
+  template<std::size_t N, std::size_t... Indices>
+  struct JSMakeIndexSequence : JSMakeIndexSequence<N - 1, N - 1, Indices...> {
+  };
+
+  template<std::size_t... Indices>
+  struct JSMakeIndexSequence<0, Indices...> {
+    using type = JSIndexSequence<Indices...>;
+  };
+
+  template<typename T>
+  struct JSVoid {
+    using type = void;
+  };
+
+  // The signature of a C++ callable: a function pointer, or a class
+  // with exactly one operator() such as a lambda. Other types have no
+  // result_type, which removes JSContext::CreateFunction(Callable&&)
+  // from overload resolution.
+  template<typename Callable, typename Enable>
+  struct JSNativeFunctionTraits {
+  };
+
+  template<typename Result, typename... Arguments>
+  struct JSNativeFunctionTraits<Result(*)(Arguments...), void> {
+    using result_type    = Result;
+    using argument_types = std::tuple<typename std::decay<Arguments>::type...>;
+    using indices        = typename JSMakeIndexSequence<sizeof...(Arguments)>::type;
+  };
+
+  template<typename Class, typename Result, typename... Arguments>
+  struct JSNativeFunctionTraits<Result(Class::*)(Arguments...), void> : JSNativeFunctionTraits<Result(*)(Arguments...), void> {
+  };
+
+  template<typename Class, typename Result, typename... Arguments>
+  struct JSNativeFunctionTraits<Result(Class::*)(Arguments...) const, void> : JSNativeFunctionTraits<Result(*)(Arguments...), void> {
+  };
+
+  template<typename Callable>
+  struct JSNativeFunctionTraits<Callable, typename JSVoid<decltype(&Callable::operator())>::type> : JSNativeFunctionTraits<decltype(&Callable::operator()), void> {
+  };
+
+  /*!
+   @class
+
+   @discussion A JSNativeFunction implements JSContext::CreateFunction
+   for C++ callables. Each Callable type gets one JSClass whose
+   callAsFunction callback is a static trampoline: it finds the
+   callable in the function object's private data, converts the
+   arguments to the callable's parameter types with JSValueConverter,
+   and converts the result back. Nothing is looked up by name.
+
+   Missing arguments convert from undefined. A C++ exception thrown by
+   the callable or by a conversion is thrown into JavaScript as an
+   Error with the exception's message.
+   */
+  template<typename Callable>
+  class JSNativeFunction final {
+
+    using Traits = JSNativeFunctionTraits<Callable, void>;
+
+  public:
+
+    template<typename T>
+    static JSObjectRef Create(JSContextRef js_context_ref, T&& callable) {
+      JSObjectRef js_object_ref = JSObjectMake(js_context_ref, GetClass(), new Callable(std::forward<T>(callable)));
+      JSObjectSetPrototype(js_context_ref, js_object_ref, GetFunctionPrototype(js_context_ref));
+      return js_object_ref;
+    }
+
+  private:
+
+    static JSClassRef GetClass() {
+      static const JSClassRef js_class_ref = CreateClass();
+      return js_class_ref;
+    }
+
+    static JSClassRef CreateClass() {
+      ::JSClassDefinition js_class_definition = kJSClassDefinitionEmpty;
+      js_class_definition.className      = "Function";
+      js_class_definition.callAsFunction = CallAsFunction;
+      js_class_definition.finalize       = Finalize;
+      return JSClassCreate(&js_class_definition);
+    }
+
+    // Give the function Function.prototype, so that call, apply and
+    // bind work as they do for any other function.
+    static JSValueRef GetFunctionPrototype(JSContextRef js_context_ref) {
+      static JSStringRefHolder function_name(JSStringCreateWithUTF8CString("Function"));
+      static JSStringRefHolder prototype_name(JSStringCreateWithUTF8CString("prototype"));
+      JSObjectRef global_object_ref = JSContextGetGlobalObject(js_context_ref);
+      JSValueRef  function_ref      = JSObjectGetProperty(js_context_ref, global_object_ref, function_name.js_string_ref__, nullptr);
+      return JSObjectGetProperty(js_context_ref, JSValueToObject(js_context_ref, function_ref, nullptr), prototype_name.js_string_ref__, nullptr);
+    }
+
+    static JSValueRef CallAsFunction(JSContextRef js_context_ref, JSObjectRef function_ref, JSObjectRef, size_t argument_count, const JSValueRef arguments_array[], JSValueRef* exception) {
+      try {
+        auto& callable = *static_cast<Callable*>(JSObjectGetPrivate(function_ref));
+        return Invoke(js_context_ref, callable, argument_count, arguments_array, typename Traits::indices(), std::is_void<typename Traits::result_type>());
+      } catch (const std::exception& e) {
+        *exception = MakeError(js_context_ref, e.what());
+      } catch (...) {
+        *exception = MakeError(js_context_ref, "unknown exception");
+      }
+      return nullptr;
+    }
+
+    static void Finalize(JSObjectRef object_ref) {
+      delete static_cast<Callable*>(JSObjectGetPrivate(object_ref));
+      JSObjectSetPrivate(object_ref, nullptr);
+    }
+
+    template<std::size_t Index>
+    static typename std::tuple_element<Index, typename Traits::argument_types>::type GetArgument(JSContextRef js_context_ref, size_t argument_count, const JSValueRef arguments_array[]) {
+      using Argument = typename std::tuple_element<Index, typename Traits::argument_types>::type;
+      JSValueRef js_value_ref = Index < argument_count ? arguments_array[Index] : JSValueMakeUndefined(js_context_ref);
+      return JSValueConverter<Argument>::FromJSValueRef(js_context_ref, js_value_ref);
+    }
+
+    template<std::size_t... Indices>
+    static JSValueRef Invoke(JSContextRef js_context_ref, Callable& callable, size_t argument_count, const JSValueRef arguments_array[], JSIndexSequence<Indices...>, std::true_type) {
+      // Unused when the callable takes no arguments.
+      static_cast<void>(argument_count);
+      static_cast<void>(arguments_array);
+      callable(GetArgument<Indices>(js_context_ref, argument_count, arguments_array)...);
+      return JSValueMakeUndefined(js_context_ref);
+    }
+
+    template<std::size_t... Indices>
+    static JSValueRef Invoke(JSContextRef js_context_ref, Callable& callable, size_t argument_count, const JSValueRef arguments_array[], JSIndexSequence<Indices...>, std::false_type) {
+      // Unused when the callable takes no arguments.
+      static_cast<void>(argument_count);
+      static_cast<void>(arguments_array);
+      using Result = typename std::decay<typename Traits::result_type>::type;
+      return ToJSValueRefArgument<Result>(js_context_ref, callable(GetArgument<Indices>(js_context_ref, argument_count, arguments_array)...));
+    }
+
+    static JSValueRef MakeError(JSContextRef js_context_ref, const char* message) {
+      JSValueRef message_ref = JSValueConverter<const char*>::ToJSValueRef(js_context_ref, message);
+      return JSObjectMakeError(js_context_ref, 1, &message_ref, nullptr);
+    }
+  };
+
+}} // namespace HAL { namespace detail {
+
+namespace HAL {
+
+  template<typename Callable, typename>
+  JSObject JSContext::CreateFunction(Callable&& callable) const {
+    using NativeFunction = detail::JSNativeFunction<typename std::decay<Callable>::type>;
+    return JSObject(*this, NativeFunction::Create(js_global_context_ref__, std::forward<Callable>(callable)));
+  }
+
+} // namespace HAL {
+
+#endif // _HAL_DETAIL_JSNATIVEFUNCTION_HPP_
@@ -15,6 +15,11 @@
 namespace HAL { namespace detail {
   
   // Add -DHAL_PERFORMANCE_COUNTER_ENABLE=1 to enable the performance counters.
+  //
+  // Classes that assign by copy-and-swap, such as JSValue and JSObject,
+  // count an assignment as a copy or move construction of the
+  // assignment operator's parameter, so the copy and move construction
+  // counts show whether values are being moved through the API.
   
   template <typename T>
   class JSPerformanceCounter {
@@ -62,20 +67,20 @@ namespace HAL { namespace detail {
     }
     
     // Move constructor.
-    JSPerformanceCounter(JSPerformanceCounter&& rhs) {
+    JSPerformanceCounter(JSPerformanceCounter&& rhs) HAL_NOEXCEPT {
       ++objects_alive_;
       ++objects_created_;
       ++objects_move_constructed_;
     }
     
     // copy assignment operator
-    JSPerformanceCounter& operator=(const JSPerformanceCounter&& rhs) {
+    JSPerformanceCounter& operator=(const JSPerformanceCounter& rhs) {
       ++objects_copy_assigned_;
       return *this;
     }
     
     // move assignment operator
-    JSPerformanceCounter& operator=(JSPerformanceCounter&& rhs) {
+    JSPerformanceCounter& operator=(JSPerformanceCounter&& rhs) HAL_NOEXCEPT {
       ++objects_move_assigned_;
       return *this;
     }
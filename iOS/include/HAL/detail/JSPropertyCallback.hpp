@@ -53,6 +53,12 @@ namespace HAL { namespace detail {
       return attributes__;
     }
     
+    // Return the property attributes as a bitmask, without copying
+    // the set.
+    JSPropertyAttributes get_property_attributes() const HAL_NOEXCEPT {
+      return JSPropertyAttributes(attributes__);
+    }
+    
     virtual ~JSPropertyCallback()                            = default;
     JSPropertyCallback(const JSPropertyCallback&)            HAL_NOEXCEPT;
     JSPropertyCallback(JSPropertyCallback&&)                 HAL_NOEXCEPT;
@@ -80,13 +86,10 @@ namespace HAL { namespace detail {
     std::unordered_set<JSPropertyAttribute> attributes__;
 #pragma warning(pop)
     
-#undef HAL_DETAIL_JSPROPERTYCALLBACK_LOCK_GUARD
-#ifdef HAL_THREAD_SAFE
-    std::recursive_mutex             mutex__;
-#define HAL_DETAIL_JSPROPERTYCALLBACK_LOCK_GUARD std::lock_guard<std::recursive_mutex> lock_guard(mutex__)
-#else
+    // A property callback isn't changed once its class is built, so
+    // there is nothing to check.
+#undef  HAL_DETAIL_JSPROPERTYCALLBACK_LOCK_GUARD
 #define HAL_DETAIL_JSPROPERTYCALLBACK_LOCK_GUARD
-#endif  // HAL_THREAD_SAFE
   };
   
   inline
@@ -0,0 +1,115 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_DETAIL_JSSCRIPTBUNDLEFORMAT_HPP_
+#define _HAL_DETAIL_JSSCRIPTBUNDLEFORMAT_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace HAL { namespace detail {
+
+  /*!
+   @class
+
+   @discussion The layout of a script bundle, as written by the
+   JSScriptBundlePacker tool and read by JSScriptBundle.
+
+   A bundle is a header, the scripts' sources as UTF-16, their names as
+   UTF-8, and an index of entries sorted by name, in that order. All
+   integers are little-endian and every offset is from the start of
+   the bundle. Sources start on 8 byte boundaries, so that a source
+   in a mapped bundle can be handed to JavaScriptCore without copying.
+   */
+  struct JSScriptBundleHeader final {
+
+    static const std::uint32_t kVersion = 1;
+
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t script_count;
+    std::uint64_t index_offset;
+    std::uint64_t size;
+
+    static const char* GetMagic() HAL_NOEXCEPT {
+      return "HALJSBND";
+    }
+  };
+
+  struct JSScriptBundleEntry final {
+    std::uint64_t name_offset;
+    std::uint64_t name_size;
+    std::uint64_t source_offset;
+    std::uint64_t source_length; // in UTF-16 code units
+  };
+
+  static_assert(sizeof(JSScriptBundleHeader) == 32, "JSScriptBundleHeader must have no padding");
+  static_assert(sizeof(JSScriptBundleEntry)  == 32, "JSScriptBundleEntry must have no padding");
+
+  // Compare the name of an entry of a validated bundle with the given
+  // name, in the order of the index.
+  inline
+  int CompareJSScriptBundleName(const char* bundle, const JSScriptBundleEntry& entry, const char* name, std::size_t name_size) HAL_NOEXCEPT {
+    const std::size_t entry_name_size = static_cast<std::size_t>(entry.name_size);
+    const int result = std::memcmp(bundle + entry.name_offset, name, entry_name_size < name_size ? entry_name_size : name_size);
+    if (result != 0) {
+      return result;
+    }
+    return entry_name_size < name_size ? -1 : (entry_name_size > name_size ? 1 : 0);
+  }
+
+  /*!
+   @function
+
+   @abstract Check that the given bytes are a well formed bundle, so
+   that reading it never goes out of bounds.
+
+   @result An empty string if the bundle is well formed, otherwise why
+   it isn't.
+   */
+  inline
+  std::string ValidateJSScriptBundle(const char* bundle, std::size_t size) {
+    if (size < sizeof(JSScriptBundleHeader)) {
+      return "too small to be a script bundle";
+    }
+    const auto header = reinterpret_cast<const JSScriptBundleHeader*>(bundle);
+    if (std::memcmp(header -> magic, JSScriptBundleHeader::GetMagic(), sizeof(header -> magic)) != 0) {
+      return "not a script bundle";
+    }
+    if (header -> version != JSScriptBundleHeader::kVersion) {
+      return "unsupported script bundle version " + std::to_string(header -> version);
+    }
+    if (header -> size != size) {
+      return "truncated script bundle";
+    }
+    if (header -> index_offset % alignof(JSScriptBundleEntry) != 0 || header -> index_offset > size || (size - header -> index_offset) / sizeof(JSScriptBundleEntry) < header -> script_count) {
+      return "script bundle index out of bounds";
+    }
+    const auto entries = reinterpret_cast<const JSScriptBundleEntry*>(bundle + header -> index_offset);
+    for (std::uint32_t i = 0; i < header -> script_count; ++i) {
+      const auto& entry = entries[i];
+      if (entry.name_offset > size || entry.name_size > size - entry.name_offset) {
+        return "script bundle entry " + std::to_string(i) + " has a name out of bounds";
+      }
+      if (entry.source_offset % 8 != 0 || entry.source_offset > size || entry.source_length > (size - entry.source_offset) / sizeof(char16_t)) {
+        return "script bundle entry " + std::to_string(i) + " has a source out of bounds";
+      }
+      if (i > 0 && CompareJSScriptBundleName(bundle, entries[i - 1], bundle + entry.name_offset, static_cast<std::size_t>(entry.name_size)) >= 0) {
+        return "script bundle index is not sorted by name";
+      }
+    }
+    return "";
+  }
+
+}} // namespace HAL { namespace detail {
+
+#endif // _HAL_DETAIL_JSSCRIPTBUNDLEFORMAT_HPP_
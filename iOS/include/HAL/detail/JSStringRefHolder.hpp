@@ -0,0 +1,65 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_DETAIL_JSSTRINGREFHOLDER_HPP_
+#define _HAL_DETAIL_JSSTRINGREFHOLDER_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+
+#include <cstddef>
+
+namespace HAL { namespace detail {
+  
+  /*!
+   @class
+   
+   @discussion A JSStringRefHolder releases a JavaScriptCore C API
+   JSStringRef when it goes out of scope. It is used internally where
+   a temporary JSStringRef is needed and the overhead of a JSString
+   (which also caches UTF-8 and UTF-16 copies of the string) is not
+   warranted.
+   */
+  // Create a JSStringRef for UTF-16 code units that outlive it, such
+  // as a string literal's. With HAL_PRIVATE_API_ENABLE it refers to
+  // them instead of copying them.
+  inline
+  JSStringRef CreateJSStringRefNoCopy(const JSChar* characters, std::size_t length) {
+#ifdef HAL_PRIVATE_API_ENABLE
+    return JSStringCreateWithCharactersNoCopy(characters, length);
+#else
+    return JSStringCreateWithCharacters(characters, length);
+#endif
+  }
+
+  struct JSStringRefHolder final {
+    
+    explicit JSStringRefHolder(JSStringRef js_string_ref) HAL_NOEXCEPT
+    : js_string_ref__(js_string_ref) {
+    }
+    
+    ~JSStringRefHolder() HAL_NOEXCEPT {
+      if (js_string_ref__) {
+        JSStringRelease(js_string_ref__);
+      }
+    }
+    
+    JSStringRefHolder(JSStringRefHolder&& rhs) HAL_NOEXCEPT
+    : js_string_ref__(rhs.js_string_ref__) {
+      rhs.js_string_ref__ = nullptr;
+    }
+    
+    JSStringRefHolder(const JSStringRefHolder&)            = delete;
+    JSStringRefHolder& operator=(const JSStringRefHolder&) = delete;
+    JSStringRefHolder& operator=(JSStringRefHolder&&)      = delete;
+    
+    JSStringRef js_string_ref__;
+  };
+  
+}} // namespace HAL { namespace detail {
+
+#endif // _HAL_DETAIL_JSSTRINGREFHOLDER_HPP_
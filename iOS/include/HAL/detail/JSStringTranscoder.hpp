@@ -0,0 +1,334 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_DETAIL_JSSTRINGTRANSCODER_HPP_
+#define _HAL_DETAIL_JSSTRINGTRANSCODER_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Select the widest vector unit available at compile time. Each one
+// only accelerates runs of ASCII, which is what the vast majority of
+// property names and identifiers are; everything else goes through
+// the scalar code below.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define HAL_DETAIL_JSSTRINGTRANSCODER_AVX2
+#define HAL_DETAIL_JSSTRINGTRANSCODER_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAL_DETAIL_JSSTRINGTRANSCODER_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define HAL_DETAIL_JSSTRINGTRANSCODER_NEON
+#endif
+
+// The conversions defined in these headers use the transcoder:
+// JSValueConverter for std::string, the JSString string_view
+// constructors and JSStringUnits, JSFunctionCache and JSModuleLoader.
+// JSString's constructors from const char* and std::string, its
+// JSStringRef constructor and its std::string and std::u16string
+// conversion operators are defined in the prebuilt HAL library and
+// still convert with std::wstring_convert. tools/
+// JSStringTranscoderBenchmark.cpp compares the two.
+
+namespace HAL { namespace detail {
+
+  /*!
+   @struct
+
+   @discussion The result of transcoding a string.
+
+   @field length The number of code units written to the output.
+
+   @field valid false if the input was not well-formed, in which case
+   each ill-formed sequence was replaced with U+FFFD.
+   */
+  struct JSTranscodeResult {
+    std::size_t length;
+    bool        valid;
+  };
+
+  // The SIMD kernels below copy whole blocks of ASCII and return the
+  // number of code units they consumed. They stop at the first block
+  // that contains a non-ASCII code unit and leave it to the scalar
+  // code.
+
+  template<typename Char16>
+  std::size_t TranscodeASCIIBlocks(const unsigned char* input, std::size_t length, Char16* output) HAL_NOEXCEPT {
+    std::size_t i = 0;
+#ifdef HAL_DETAIL_JSSTRINGTRANSCODER_AVX2
+    for (; i + 32 <= length; i += 32) {
+      const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+      if (_mm256_movemask_epi8(bytes) != 0) {
+        break;
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i)     , _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+    }
+#endif
+#ifdef HAL_DETAIL_JSSTRINGTRANSCODER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+      const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+      if (_mm_movemask_epi8(bytes) != 0) {
+        break;
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i)    , _mm_unpacklo_epi8(bytes, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 8), _mm_unpackhi_epi8(bytes, zero));
+    }
+#endif
+#ifdef HAL_DETAIL_JSSTRINGTRANSCODER_NEON
+    for (; i + 16 <= length; i += 16) {
+      const uint8x16_t bytes = vld1q_u8(input + i);
+      if (vmaxvq_u8(bytes) >= 0x80) {
+        break;
+      }
+      vst1q_u16(reinterpret_cast<std::uint16_t*>(output + i)    , vmovl_u8(vget_low_u8(bytes)));
+      vst1q_u16(reinterpret_cast<std::uint16_t*>(output + i + 8), vmovl_u8(vget_high_u8(bytes)));
+    }
+#endif
+    static_cast<void>(input);
+    static_cast<void>(length);
+    static_cast<void>(output);
+    return i;
+  }
+
+  template<typename Char16>
+  std::size_t TranscodeASCIIBlocks(const Char16* input, std::size_t length, unsigned char* output) HAL_NOEXCEPT {
+    std::size_t i = 0;
+#ifdef HAL_DETAIL_JSSTRINGTRANSCODER_AVX2
+    const __m256i non_ascii_mask_256 = _mm256_set1_epi16(static_cast<short>(0xFF80));
+    for (; i + 32 <= length; i += 32) {
+      const __m256i low  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+      const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i + 16));
+      if (!_mm256_testz_si256(_mm256_or_si256(low, high), non_ascii_mask_256)) {
+        break;
+      }
+      // _mm256_packus_epi16 packs within 128-bit lanes, so restore the
+      // order of the 64-bit quarters afterwards.
+      const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+    }
+#endif
+#ifdef HAL_DETAIL_JSSTRINGTRANSCODER_SSE2
+    const __m128i non_ascii_mask = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero           = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+      const __m128i low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+      const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 8));
+      const __m128i non_ascii = _mm_and_si128(_mm_or_si128(low, high), non_ascii_mask);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, zero)) != 0xFFFF) {
+        break;
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(low, high));
+    }
+#endif
+#ifdef HAL_DETAIL_JSSTRINGTRANSCODER_NEON
+    for (; i + 16 <= length; i += 16) {
+      const uint16x8_t low  = vld1q_u16(reinterpret_cast<const std::uint16_t*>(input + i));
+      const uint16x8_t high = vld1q_u16(reinterpret_cast<const std::uint16_t*>(input + i + 8));
+      if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80) {
+        break;
+      }
+      vst1q_u8(output + i, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+    }
+#endif
+    static_cast<void>(input);
+    static_cast<void>(length);
+    static_cast<void>(output);
+    return i;
+  }
+
+  /*!
+   @function
+
+   @abstract Convert UTF-8 to UTF-16, validating the input in the same
+   pass.
+
+   @param input The UTF-8 input. It need not be null-terminated and
+   may contain embedded nulls.
+
+   @param length The number of bytes in input.
+
+   @param output A buffer with room for at least length UTF-16 code
+   units.
+
+   @result The number of UTF-16 code units written, and whether the
+   input was well-formed UTF-8.
+   */
+  template<typename Char16>
+  JSTranscodeResult TranscodeUTF8ToUTF16(const char* input, std::size_t length, Char16* output) HAL_NOEXCEPT {
+    static_assert(sizeof(Char16) == 2, "Char16 must be a 16-bit code unit");
+
+    const unsigned char* in  = reinterpret_cast<const unsigned char*>(input);
+    const unsigned char* end = in + length;
+    Char16*              out = output;
+    bool                 valid = true;
+
+    while (in < end) {
+      // Only try the vector unit at the start of a run of ASCII, so
+      // that text without any ASCII doesn't pay for it.
+      if (*in < 0x80) {
+        const std::size_t ascii_length = TranscodeASCIIBlocks(in, static_cast<std::size_t>(end - in), out);
+        in  += ascii_length;
+        out += ascii_length;
+
+        // Finish the run of ASCII one byte at a time.
+        while (in < end && *in < 0x80) {
+          *out++ = static_cast<Char16>(*in++);
+        }
+        if (in == end) {
+          break;
+        }
+      }
+
+      const std::uint32_t lead = *in;
+      std::size_t         continuation_count = 0;
+      std::uint32_t       code_point = 0;
+      unsigned char       second_min = 0x80;
+      unsigned char       second_max = 0xBF;
+
+      if (lead >= 0xC2 && lead <= 0xDF) {
+        continuation_count = 1;
+        code_point         = lead & 0x1F;
+      } else if (lead >= 0xE0 && lead <= 0xEF) {
+        continuation_count = 2;
+        code_point         = lead & 0x0F;
+        second_min         = (lead == 0xE0) ? 0xA0 : 0x80; // overlong
+        second_max         = (lead == 0xED) ? 0x9F : 0xBF; // surrogates
+      } else if (lead >= 0xF0 && lead <= 0xF4) {
+        continuation_count = 3;
+        code_point         = lead & 0x07;
+        second_min         = (lead == 0xF0) ? 0x90 : 0x80; // overlong
+        second_max         = (lead == 0xF4) ? 0x8F : 0xBF; // > U+10FFFF
+      } else {
+        *out++ = static_cast<Char16>(0xFFFD);
+        valid  = false;
+        ++in;
+        continue;
+      }
+
+      // Consume the maximal well-formed prefix of the sequence, and
+      // replace it with a single U+FFFD if it is incomplete.
+      std::size_t consumed = 1;
+      for (; consumed <= continuation_count && in + consumed < end; ++consumed) {
+        const unsigned char byte = in[consumed];
+        const unsigned char min  = (consumed == 1) ? second_min : 0x80;
+        const unsigned char max  = (consumed == 1) ? second_max : 0xBF;
+        if (byte < min || byte > max) {
+          break;
+        }
+        code_point = (code_point << 6) | (byte & 0x3F);
+      }
+
+      in += consumed;
+      if (consumed != continuation_count + 1) {
+        *out++ = static_cast<Char16>(0xFFFD);
+        valid  = false;
+      } else if (code_point >= 0x10000) {
+        code_point -= 0x10000;
+        *out++ = static_cast<Char16>(0xD800 + (code_point >> 10));
+        *out++ = static_cast<Char16>(0xDC00 + (code_point & 0x3FF));
+      } else {
+        *out++ = static_cast<Char16>(code_point);
+      }
+    }
+
+    return { static_cast<std::size_t>(out - output), valid };
+  }
+
+  /*!
+   @function
+
+   @abstract Convert UTF-16 to UTF-8, validating the input in the same
+   pass.
+
+   @param input The UTF-16 input, such as the characters of a
+   JSStringRef.
+
+   @param length The number of code units in input.
+
+   @param output A buffer with room for at least 3 * length bytes.
+
+   @result The number of bytes written, and whether the input was
+   well-formed UTF-16. Unpaired surrogates, which JavaScript strings
+   may contain, are replaced with U+FFFD.
+   */
+  template<typename Char16>
+  JSTranscodeResult TranscodeUTF16ToUTF8(const Char16* input, std::size_t length, char* output) HAL_NOEXCEPT {
+    static_assert(sizeof(Char16) == 2, "Char16 must be a 16-bit code unit");
+
+    const Char16*  in  = input;
+    const Char16*  end = in + length;
+    unsigned char* out = reinterpret_cast<unsigned char*>(output);
+    bool           valid = true;
+
+    while (in < end) {
+      // Only try the vector unit at the start of a run of ASCII, so
+      // that text without any ASCII doesn't pay for it.
+      if (static_cast<std::uint16_t>(*in) < 0x80) {
+        const std::size_t ascii_length = TranscodeASCIIBlocks(in, static_cast<std::size_t>(end - in), out);
+        in  += ascii_length;
+        out += ascii_length;
+      }
+
+      while (in < end) {
+        const std::uint32_t code_unit = static_cast<std::uint16_t>(*in++);
+        if (code_unit < 0x80) {
+          *out++ = static_cast<unsigned char>(code_unit);
+          if (in < end && static_cast<std::uint16_t>(*in) < 0x80) {
+            break;
+          }
+        } else if (code_unit < 0x800) {
+          *out++ = static_cast<unsigned char>(0xC0 | (code_unit >> 6));
+          *out++ = static_cast<unsigned char>(0x80 | (code_unit & 0x3F));
+        } else if (code_unit < 0xD800 || code_unit > 0xDFFF) {
+          *out++ = static_cast<unsigned char>(0xE0 | (code_unit >> 12));
+          *out++ = static_cast<unsigned char>(0x80 | ((code_unit >> 6) & 0x3F));
+          *out++ = static_cast<unsigned char>(0x80 | (code_unit & 0x3F));
+        } else if (code_unit <= 0xDBFF && in < end && static_cast<std::uint16_t>(*in) >= 0xDC00 && static_cast<std::uint16_t>(*in) <= 0xDFFF) {
+          const std::uint32_t code_point = 0x10000 + ((code_unit - 0xD800) << 10) + (static_cast<std::uint16_t>(*in++) - 0xDC00);
+          *out++ = static_cast<unsigned char>(0xF0 | (code_point >> 18));
+          *out++ = static_cast<unsigned char>(0x80 | ((code_point >> 12) & 0x3F));
+          *out++ = static_cast<unsigned char>(0x80 | ((code_point >> 6) & 0x3F));
+          *out++ = static_cast<unsigned char>(0x80 | (code_point & 0x3F));
+        } else {
+          *out++ = 0xEF;
+          *out++ = 0xBF;
+          *out++ = 0xBD;
+          valid  = false;
+        }
+      }
+    }
+
+    return { static_cast<std::size_t>(out - reinterpret_cast<unsigned char*>(output)), valid };
+  }
+
+  // Convenience function to convert UTF-16 to a UTF-8 std::string.
+  template<typename Char16>
+  std::string ToUTF8String(const Char16* input, std::size_t length) {
+    std::string result(length * 3, '\0');
+    result.resize(TranscodeUTF16ToUTF8(input, length, &result[0]).length);
+    return result;
+  }
+
+  // Convenience function to convert UTF-8 to a UTF-16 std::u16string.
+  inline
+  std::u16string ToUTF16String(const char* input, std::size_t length) {
+    std::u16string result(length, u'\0');
+    result.resize(TranscodeUTF8ToUTF16(input, length, &result[0]).length);
+    return result;
+  }
+
+}} // namespace HAL { namespace detail {
+
+#endif // _HAL_DETAIL_JSSTRINGTRANSCODER_HPP_
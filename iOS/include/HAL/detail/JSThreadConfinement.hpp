@@ -0,0 +1,163 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_DETAIL_JSTHREADCONFINEMENT_HPP_
+#define _HAL_DETAIL_JSTHREADCONFINEMENT_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace HAL { namespace detail {
+
+  class JSExecutorQueue;
+
+  /*!
+   @class
+
+   @discussion JSThreadConfinement records which JSContextGroups are
+   bound to an executor thread, and the queue that runs tasks on it.
+   A JSContextGroup that isn't bound may be used on any thread, as
+   before, with the caller providing any synchronization.
+
+   HAL's value classes don't lock. Instead, in debug builds each of
+   their operations checks that the calling thread owns the value's
+   context group. Checking a value on its own executor thread only
+   compares a thread-specific value, and checking a value when no
+   group is bound only reads an atomic.
+
+   The thread-specific value is kept with pthread_getspecific rather
+   than thread_local, which Apple clang rejects for deployment targets
+   before iOS 9.
+   */
+  class JSThreadConfinement final {
+
+  public:
+
+    static void Bind(JSContextGroupRef js_context_group_ref, std::thread::id thread_id, const std::shared_ptr<JSExecutorQueue>& queue) {
+      auto& registry = GetRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.bindings[js_context_group_ref] = Binding { thread_id, queue };
+      registry.size.store(registry.bindings.size());
+    }
+
+    static void Unbind(JSContextGroupRef js_context_group_ref) {
+      auto& registry = GetRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.bindings.erase(js_context_group_ref);
+      registry.size.store(registry.bindings.size());
+    }
+
+    // Return the queue of the given group's executor, or nullptr if
+    // the group isn't bound.
+    static std::shared_ptr<JSExecutorQueue> Find(JSContextGroupRef js_context_group_ref) {
+      auto& registry = GetRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      const auto position = registry.bindings.find(js_context_group_ref);
+      return position == registry.bindings.end() ? nullptr : position -> second.queue;
+    }
+
+    // Record that the calling thread is the executor thread of the
+    // given group.
+    static void SetCurrentGroup(JSContextGroupRef js_context_group_ref) HAL_NOEXCEPT {
+#ifdef _WIN32
+      GetCurrentGroupSlot() = js_context_group_ref;
+#else
+      pthread_setspecific(GetCurrentGroupKey(), js_context_group_ref);
+#endif
+    }
+
+    // Return true if the calling thread may use the given group: it is
+    // either the group's executor thread or the group isn't bound.
+    static bool IsOwner(JSContextGroupRef js_context_group_ref) {
+      if (js_context_group_ref == GetCurrentGroup()) {
+        return true;
+      }
+      auto& registry = GetRegistry();
+      if (registry.size.load() == 0) {
+        return true;
+      }
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      const auto position = registry.bindings.find(js_context_group_ref);
+      return position == registry.bindings.end() || position -> second.thread_id == std::this_thread::get_id();
+    }
+
+    static void Check(JSContextRef js_context_ref) {
+      if (js_context_ref == nullptr) {
+        return;
+      }
+      const bool is_owner = IsOwner(JSContextGetGroup(js_context_ref));
+      if (!is_owner) {
+        HAL_LOG_ERROR("JSThreadConfinement: JSContextRef ", js_context_ref, " used outside its executor thread; use JSContextGroup::Post or JSContextGroup::Invoke");
+      }
+      assert(is_owner);
+    }
+
+  private:
+
+    struct Binding final {
+      std::thread::id                  thread_id;
+      std::shared_ptr<JSExecutorQueue> queue;
+    };
+
+    struct Registry final {
+      std::mutex                                     mutex;
+      std::unordered_map<JSContextGroupRef, Binding> bindings;
+      std::atomic<std::size_t>                       size { 0 };
+    };
+
+    // The registry is never destroyed, so that values released during
+    // static destruction can still be checked.
+    static Registry& GetRegistry() {
+      static Registry* registry = new Registry();
+      return *registry;
+    }
+
+    static JSContextGroupRef GetCurrentGroup() HAL_NOEXCEPT {
+#ifdef _WIN32
+      return GetCurrentGroupSlot();
+#else
+      return static_cast<JSContextGroupRef>(pthread_getspecific(GetCurrentGroupKey()));
+#endif
+    }
+
+#ifdef _WIN32
+    static JSContextGroupRef& GetCurrentGroupSlot() HAL_NOEXCEPT {
+      static __declspec(thread) JSContextGroupRef js_context_group_ref = nullptr;
+      return js_context_group_ref;
+    }
+#else
+    // The key is never deleted, for the same reason as the registry.
+    static pthread_key_t GetCurrentGroupKey() HAL_NOEXCEPT {
+      static const pthread_key_t key = CreateCurrentGroupKey();
+      return key;
+    }
+
+    static pthread_key_t CreateCurrentGroupKey() HAL_NOEXCEPT {
+      pthread_key_t key;
+      const int result = pthread_key_create(&key, nullptr);
+      static_cast<void>(result);
+      assert(result == 0);
+      return key;
+    }
+#endif
+  };
+
+}} // namespace HAL { namespace detail {
+
+#endif // _HAL_DETAIL_JSTHREADCONFINEMENT_HPP_
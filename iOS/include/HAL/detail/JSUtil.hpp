@@ -56,6 +56,10 @@ namespace HAL { namespace detail {
     std::vector<JSValue> js_stack() const {
       return js_stack__;
     }
+    // Return the stack without copying it.
+    const std::vector<JSValue>& get_js_stack() const HAL_NOEXCEPT {
+      return js_stack__;
+    }
   private:
     std::string js_name__;
     std::string js_message__;
@@ -83,11 +87,21 @@ namespace HAL { namespace detail {
   HAL_EXPORT std::string to_string(const std::unordered_set<JSPropertyAttribute>& attributes)                    HAL_NOEXCEPT;
   HAL_EXPORT std::string to_string_JSPropertyAttributes(::JSPropertyAttributes attributes)                       HAL_NOEXCEPT;
   
+  inline
+  std::string to_string(JSPropertyAttributes attributes) HAL_NOEXCEPT {
+    return to_string_JSPropertyAttributes(static_cast<::JSPropertyAttributes>(attributes));
+  }
+  
   HAL_EXPORT unsigned ToJSClassAttribute(JSClassAttribute attribute)                                             HAL_NOEXCEPT;
   HAL_EXPORT std::unordered_set<JSClassAttribute> FromJSClassAttributes(::JSClassAttributes attributes)          HAL_NOEXCEPT;
   HAL_EXPORT std::string to_string(JSClassAttribute)                                                             HAL_NOEXCEPT;
   HAL_EXPORT std::string to_string(const std::unordered_set<JSClassAttribute>& attributes)                       HAL_NOEXCEPT;
   HAL_EXPORT std::string to_string_JSClassAttributes(::JSClassAttributes attributes)                             HAL_NOEXCEPT;
+  
+  inline
+  std::string to_string(JSClassAttributes attributes) HAL_NOEXCEPT {
+    return to_string_JSClassAttributes(static_cast<::JSClassAttributes>(attributes));
+  }
 
   // This in the ToInt32 operation as defined in section 9.5 of the
   // ECMA-262 spec. Note that this operation is identical to ToUInt32
@@ -0,0 +1,320 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+#ifndef _HAL_DETAIL_JSVALUECONVERTER_HPP_
+#define _HAL_DETAIL_JSVALUECONVERTER_HPP_
+
+#include "HAL/detail/JSBase.hpp"
+#include "HAL/JSContext.hpp"
+#include "HAL/JSString.hpp"
+#include "HAL/JSValue.hpp"
+#include "HAL/JSObject.hpp"
+#include "HAL/detail/JSUtil.hpp"
+#include "HAL/detail/JSStringRefHolder.hpp"
+#include "HAL/detail/JSStringTranscoder.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <type_traits>
+
+namespace HAL { namespace detail {
+
+  /*!
+   @class
+
+   @discussion A JSValueConverter converts between a C++ type T and a
+   JavaScriptCore C API JSValueRef without creating any intermediate
+   HAL wrapper objects. Specializations are provided for bool, the
+   arithmetic types, std::string, JSString, JSValue, JSObject,
+   std::vector of any convertible type, and any type described by
+   HAL_REFLECT.
+
+   Each specialization provides the following two static functions:
+
+   static JSValueRef ToJSValueRef(JSContextRef, const T&);
+   static T FromJSValueRef(JSContextRef, JSValueRef);
+
+   Both throw a std::runtime_error if a JavaScript exception is
+   thrown during the conversion.
+
+   The JSValueRef returned by ToJSValueRef is not protected from
+   garbage collection, so it must either be stored in another
+   JavaScript value or wrapped in a JSValue before it leaves the
+   calling stack frame.
+   */
+  template<typename T, typename Enable = void>
+  struct JSValueConverter;
+
+  template<>
+  struct JSValueConverter<JSValue> {
+
+    static JSValueRef ToJSValueRef(JSContextRef, const JSValue& js_value) HAL_NOEXCEPT {
+      return static_cast<JSValueRef>(js_value);
+    }
+
+    static JSValue FromJSValueRef(JSContextRef js_context_ref, JSValueRef js_value_ref) {
+      return ToJSValue(js_context_ref, js_value_ref);
+    }
+
+    // Wrap a JSValueRef in a JSValue, protecting it from garbage
+    // collection.
+    static JSValue ToJSValue(JSContextRef js_context_ref, JSValueRef js_value_ref) {
+      return JSValue(JSContext(js_context_ref), js_value_ref);
+    }
+
+    static JSContextRef ToJSContextRef(const JSContext& js_context) HAL_NOEXCEPT {
+      return static_cast<JSContextRef>(js_context);
+    }
+  };
+
+  inline
+  void ThrowIfJSException(JSContextRef js_context_ref, JSValueRef exception, const std::string& internal_component_name = "JSValueConverter") {
+    if (exception) {
+      ThrowRuntimeError(internal_component_name, JSValueConverter<JSValue>::ToJSValue(js_context_ref, exception));
+    }
+  }
+
+  template<>
+  struct JSValueConverter<JSObject> {
+
+    static JSValueRef ToJSValueRef(JSContextRef, const JSObject& js_object) HAL_NOEXCEPT {
+      return static_cast<JSObjectRef>(js_object);
+    }
+
+    static JSObject FromJSValueRef(JSContextRef js_context_ref, JSValueRef js_value_ref) {
+      JSValueRef exception { nullptr };
+      JSObjectRef js_object_ref = JSValueToObject(js_context_ref, js_value_ref, &exception);
+      ThrowIfJSException(js_context_ref, exception);
+      return JSObject(JSContext(js_context_ref), js_object_ref);
+    }
+  };
+
+  template<>
+  struct JSValueConverter<bool> {
+
+    static JSValueRef ToJSValueRef(JSContextRef js_context_ref, bool value) HAL_NOEXCEPT {
+      return JSValueMakeBoolean(js_context_ref, value);
+    }
+
+    static bool FromJSValueRef(JSContextRef js_context_ref, JSValueRef js_value_ref) HAL_NOEXCEPT {
+      return JSValueToBoolean(js_context_ref, js_value_ref);
+    }
+  };
+
+  // All arithmetic types other than bool travel through a JavaScript
+  // number. Conversions to an integral type truncate towards zero and
+  // saturate at the limits of the type, and NaN converts to zero.
+  template<typename T>
+  struct JSValueConverter<T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type> {
+
+    static JSValueRef ToJSValueRef(JSContextRef js_context_ref, T value) HAL_NOEXCEPT {
+      return JSValueMakeNumber(js_context_ref, static_cast<double>(value));
+    }
+
+    static T FromJSValueRef(JSContextRef js_context_ref, JSValueRef js_value_ref) {
+      JSValueRef exception { nullptr };
+      const double number = JSValueToNumber(js_context_ref, js_value_ref, &exception);
+      ThrowIfJSException(js_context_ref, exception);
+      return FromNumber(number, std::is_integral<T>());
+    }
+
+  private:
+
+    static T FromNumber(double number, std::false_type) HAL_NOEXCEPT {
+      return static_cast<T>(number);
+    }
+
+    static T FromNumber(double number, std::true_type) HAL_NOEXCEPT {
+      if (std::isnan(number)) {
+        return 0;
+      }
+      if (number <= static_cast<double>(std::numeric_limits<T>::min())) {
+        return std::numeric_limits<T>::min();
+      }
+      if (number >= static_cast<double>(std::numeric_limits<T>::max())) {
+        return std::numeric_limits<T>::max();
+      }
+      return static_cast<T>(number);
+    }
+  };
+
+  // Strings are transcoded in one pass by JSStringTranscoder rather
+  // than through JavaScriptCore's null-terminated UTF-8 functions, so
+  // embedded nulls survive the round trip. Short strings are
+  // transcoded on the stack.
+  template<>
+  struct JSValueConverter<std::string> {
+
+    static JSValueRef ToJSValueRef(JSContextRef js_context_ref, const std::string& value) {
+      return ToJSValueRef(js_context_ref, value.data(), value.size());
+    }
+
+    static JSValueRef ToJSValueRef(JSContextRef js_context_ref, const char* data, std::size_t length) {
+      JSChar buffer[256];
+      std::vector<JSChar> heap_buffer;
+      JSChar* characters = buffer;
+      if (length > sizeof(buffer) / sizeof(buffer[0])) {
+        heap_buffer.resize(length);
+        characters = heap_buffer.data();
+      }
+      const auto result = TranscodeUTF8ToUTF16(data, length, characters);
+      JSStringRefHolder js_string(JSStringCreateWithCharacters(characters, result.length));
+      return JSValueMakeString(js_context_ref, js_string.js_string_ref__);
+    }
+
+    static std::string FromJSValueRef(JSContextRef js_context_ref, JSValueRef js_value_ref) {
+      JSValueRef exception { nullptr };
+      JSStringRefHolder js_string(JSValueToStringCopy(js_context_ref, js_value_ref, &exception));
+      ThrowIfJSException(js_context_ref, exception);
+      return ToUTF8String(JSStringGetCharactersPtr(js_string.js_string_ref__), JSStringGetLength(js_string.js_string_ref__));
+    }
+  };
+
+  // A null-terminated UTF8 C string only converts to JavaScript, since
+  // a JavaScript string can't be returned as a borrowed C string. A
+  // null pointer converts to null.
+  template<>
+  struct JSValueConverter<const char*> {
+
+    static JSValueRef ToJSValueRef(JSContextRef js_context_ref, const char* value) {
+      if (value == nullptr) {
+        return JSValueMakeNull(js_context_ref);
+      }
+      return JSValueConverter<std::string>::ToJSValueRef(js_context_ref, value, std::char_traits<char>::length(value));
+    }
+  };
+
+  // nullptr converts to null.
+  template<>
+  struct JSValueConverter<std::nullptr_t> {
+
+    static JSValueRef ToJSValueRef(JSContextRef js_context_ref, std::nullptr_t) HAL_NOEXCEPT {
+      return JSValueMakeNull(js_context_ref);
+    }
+  };
+
+  template<>
+  struct JSValueConverter<JSString> {
+
+    static JSValueRef ToJSValueRef(JSContextRef js_context_ref, const JSString& js_string) HAL_NOEXCEPT {
+      return JSValueMakeString(js_context_ref, static_cast<JSStringRef>(js_string));
+    }
+
+    static JSString FromJSValueRef(JSContextRef js_context_ref, JSValueRef js_value_ref) {
+      JSValueRef exception { nullptr };
+      JSStringRefHolder js_string(JSValueToStringCopy(js_context_ref, js_value_ref, &exception));
+      ThrowIfJSException(js_context_ref, exception);
+      return JSString(js_string.js_string_ref__);
+    }
+  };
+
+  // A std::vector converts to and from a JavaScript array. Each
+  // element is stored in the array as soon as it is converted, since
+  // converting the next one may allocate and collect garbage, and
+  // JavaScriptCore's conservative garbage collector can't see
+  // JSValueRefs kept on the heap.
+  template<typename T>
+  struct JSValueConverter<std::vector<T>> {
+
+    static JSValueRef ToJSValueRef(JSContextRef js_context_ref, const std::vector<T>& values) {
+      JSValueRef exception { nullptr };
+      JSObjectRef js_object_ref = JSObjectMakeArray(js_context_ref, 0, nullptr, &exception);
+      ThrowIfJSException(js_context_ref, exception);
+      unsigned index = 0;
+      for (const auto& value : values) {
+        JSObjectSetPropertyAtIndex(js_context_ref, js_object_ref, index++, JSValueConverter<T>::ToJSValueRef(js_context_ref, value), &exception);
+        ThrowIfJSException(js_context_ref, exception);
+      }
+      return js_object_ref;
+    }
+
+    static std::vector<T> FromJSValueRef(JSContextRef js_context_ref, JSValueRef js_value_ref) {
+      static JSStringRefHolder length_name(JSStringCreateWithUTF8CString("length"));
+
+      JSValueRef exception { nullptr };
+      JSObjectRef js_object_ref = JSValueToObject(js_context_ref, js_value_ref, &exception);
+      ThrowIfJSException(js_context_ref, exception);
+
+      JSValueRef length_ref = JSObjectGetProperty(js_context_ref, js_object_ref, length_name.js_string_ref__, &exception);
+      ThrowIfJSException(js_context_ref, exception);
+
+      const unsigned count = JSValueConverter<unsigned>::FromJSValueRef(js_context_ref, length_ref);
+      std::vector<T> values;
+      values.reserve(count);
+      for (unsigned i = 0; i < count; ++i) {
+        JSValueRef element_ref = JSObjectGetPropertyAtIndex(js_context_ref, js_object_ref, i, &exception);
+        ThrowIfJSException(js_context_ref, exception);
+        values.push_back(JSValueConverter<T>::FromJSValueRef(js_context_ref, element_ref));
+      }
+      return values;
+    }
+  };
+
+  // The JSValueConverter used for an argument of type T to a variadic
+  // call such as JSObject::Call. Classes derived from JSValue or
+  // JSObject, such as JSNumber or JSArray, convert as their base,
+  // nullptr converts to null, and string literals and character arrays
+  // convert as C strings.
+  template<typename T>
+  struct JSArgumentConverter {
+    using type = JSValueConverter<typename std::conditional<std::is_base_of<JSObject, T>::value, JSObject,
+                                  typename std::conditional<std::is_base_of<JSValue , T>::value, JSValue,
+                                  typename std::conditional<std::is_same<T, std::nullptr_t>::value, std::nullptr_t,
+                                  typename std::conditional<std::is_convertible<const T&, const char*>::value, const char*,
+                                  T>::type>::type>::type>::type>;
+  };
+
+  // Convert one argument of a variadic call without creating a
+  // JSValue.
+  template<typename T>
+  JSValueRef ToJSValueRefArgument(JSContextRef js_context_ref, const T& value) {
+    return JSArgumentConverter<T>::type::ToJSValueRef(js_context_ref, value);
+  }
+
+}} // namespace HAL { namespace detail {
+
+namespace HAL {
+
+  template<typename... Arguments>
+  JSValue JSObject::Call(const JSObject& this_object, const Arguments&... arguments) const {
+    const auto js_context_ref = static_cast<JSContextRef>(js_context__);
+    if (!JSObjectIsFunction(js_context_ref, js_object_ref__)) {
+      detail::ThrowRuntimeError("JSObject", "This JavaScript object can't be called as a function.");
+    }
+    // The arguments live on the stack until the call returns, where
+    // JavaScriptCore's conservative garbage collector can see them.
+    const JSValueRef arguments_array[sizeof...(Arguments) > 0 ? sizeof...(Arguments) : 1] = { detail::ToJSValueRefArgument(js_context_ref, arguments)... };
+    JSValueRef exception { nullptr };
+    JSValueRef js_value_ref = JSObjectCallAsFunction(js_context_ref, js_object_ref__, this_object.js_object_ref__, sizeof...(Arguments), arguments_array, &exception);
+    detail::ThrowIfJSException(js_context_ref, exception, "JSObject");
+    return JSValue(js_context__, js_value_ref);
+  }
+
+  template<typename... Arguments>
+  JSObject JSObject::Construct(const Arguments&... arguments) const {
+    const auto js_context_ref = static_cast<JSContextRef>(js_context__);
+    if (!JSObjectIsConstructor(js_context_ref, js_object_ref__)) {
+      detail::ThrowRuntimeError("JSObject", "This JavaScript object can't be called as a constructor.");
+    }
+    const JSValueRef arguments_array[sizeof...(Arguments) > 0 ? sizeof...(Arguments) : 1] = { detail::ToJSValueRefArgument(js_context_ref, arguments)... };
+    JSValueRef exception { nullptr };
+    JSObjectRef js_object_ref = JSObjectCallAsConstructor(js_context_ref, js_object_ref__, sizeof...(Arguments), arguments_array, &exception);
+    detail::ThrowIfJSException(js_context_ref, exception, "JSObject");
+    return JSObject(js_context__, js_object_ref);
+  }
+
+} // namespace HAL {
+
+// JSNativeFunction converts arguments with JSValueConverter to define
+// JSContext::CreateFunction for C++ callables.
+#include "HAL/detail/JSNativeFunction.hpp"
+
+#endif // _HAL_DETAIL_JSVALUECONVERTER_HPP_
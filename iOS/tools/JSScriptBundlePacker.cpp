@@ -0,0 +1,264 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+// Pack an application's scripts into a bundle for HAL::JSScriptBundle.
+//
+// Usage: JSScriptBundlePacker <App directory> <tiapp.xml> <bundle>
+//
+// Every .js and .json file under the App directory is packed under its
+// path relative to it, such as "/app.js", so that modules vendored
+// under App/node_modules, and their package.json files, are packed too
+// for HAL::JSModuleLoader. Each script in tiapp.xml's <scripts> and
+// each <module platform="js"> must be among them. Every script's syntax
+// and every JSON file is checked with JavaScriptCore, and the bundle is
+// only written if all of them are valid.
+
+#include "HAL/detail/JSScriptBundleFormat.hpp"
+#include "HAL/detail/JSStringTranscoder.hpp"
+
+#include <JavaScriptCore/JavaScript.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using HAL::detail::JSScriptBundleEntry;
+  using HAL::detail::JSScriptBundleHeader;
+
+  bool ReadFile(const std::string& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      return false;
+    }
+    std::ostringstream os;
+    os << file.rdbuf();
+    contents = os.str();
+    return true;
+  }
+
+  bool EndsWith(const std::string& string, const std::string& suffix) {
+    return string.size() >= suffix.size() && string.compare(string.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  // Add every .js and .json file under directory, keyed by its path
+  // relative to root.
+  void ListScripts(const std::string& root, const std::string& relative_path, std::map<std::string, std::string>& scripts) {
+    const std::string directory = root + relative_path;
+    DIR* dir = ::opendir(directory.c_str());
+    if (dir == nullptr) {
+      return;
+    }
+    while (const dirent* entry = ::readdir(dir)) {
+      const std::string name = entry -> d_name;
+      if (name == "." || name == "..") {
+        continue;
+      }
+      const std::string path = relative_path + "/" + name;
+      struct stat status;
+      if (::stat((root + path).c_str(), &status) != 0) {
+        continue;
+      }
+      if (S_ISDIR(status.st_mode)) {
+        ListScripts(root, path, scripts);
+      } else if (S_ISREG(status.st_mode) && (EndsWith(name, ".js") || EndsWith(name, ".json"))) {
+        scripts.emplace(path, root + path);
+      }
+    }
+    ::closedir(dir);
+  }
+
+  // Check that tiapp.xml's scripts and JavaScript modules are among
+  // the packed scripts.
+  bool CheckTiApp(const std::string& tiapp_xml, const std::map<std::string, std::string>& scripts) {
+    bool ok = true;
+    std::smatch match;
+    if (std::regex_search(tiapp_xml, match, std::regex("<scripts>([\\s\\S]*?)</scripts>"))) {
+      const std::string section = match[1];
+      const std::regex  script_regex("<(\\w+)>\\s*([^<]*?)\\s*</\\1>");
+      for (std::sregex_iterator i(section.begin(), section.end(), script_regex), end; i != end; ++i) {
+        std::string name = (*i)[2];
+        if (name.empty() || name[0] != '/') {
+          name = "/" + name;
+        }
+        if (scripts.count(name) == 0) {
+          std::cerr << "tiapp.xml: script " << (*i)[1] << " " << name << " is not in the App directory" << std::endl;
+          ok = false;
+        }
+      }
+    }
+    const std::regex module_regex("<module\\b[^>]*\\bplatform=\"js\"[^>]*>\\s*([^<]*?)\\s*</module>");
+    for (std::sregex_iterator i(tiapp_xml.begin(), tiapp_xml.end(), module_regex), end; i != end; ++i) {
+      const std::string prefix   = "/node_modules/" + (*i)[1].str() + "/";
+      const auto        position = scripts.lower_bound(prefix);
+      if (position == scripts.end() || position -> first.compare(0, prefix.size(), prefix) != 0) {
+        std::cerr << "tiapp.xml: module " << (*i)[1] << " has no scripts in App" << prefix << std::endl;
+        ok = false;
+      }
+    }
+    return ok;
+  }
+
+  std::string ToString(JSContextRef js_context_ref, JSValueRef js_value_ref) {
+    JSStringRef js_string_ref = JSValueToStringCopy(js_context_ref, js_value_ref, nullptr);
+    if (js_string_ref == nullptr) {
+      return "unknown error";
+    }
+    const std::string result = HAL::detail::ToUTF8String(JSStringGetCharactersPtr(js_string_ref), JSStringGetLength(js_string_ref));
+    JSStringRelease(js_string_ref);
+    return result;
+  }
+
+  // Convert a script to UTF-16 and check its syntax, or that it is
+  // JSON.
+  bool PrepareScript(JSContextRef js_context_ref, const std::string& name, std::string source, std::u16string& characters) {
+    if (source.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+      source.erase(0, 3);
+    }
+    characters.resize(source.size());
+    const auto result = HAL::detail::TranscodeUTF8ToUTF16(source.data(), source.size(), &characters[0]);
+    characters.resize(result.length);
+    if (!result.valid) {
+      std::cerr << name << ": not valid UTF-8" << std::endl;
+      return false;
+    }
+
+    JSStringRef script_ref     = JSStringCreateWithCharacters(reinterpret_cast<const JSChar*>(characters.data()), characters.size());
+    if (EndsWith(name, ".json")) {
+      const bool valid = JSValueMakeFromJSONString(js_context_ref, script_ref) != nullptr;
+      JSStringRelease(script_ref);
+      if (!valid) {
+        std::cerr << name << ": not valid JSON" << std::endl;
+      }
+      return valid;
+    }
+    JSStringRef source_url_ref = JSStringCreateWithUTF8CString(name.c_str());
+    JSValueRef  exception      = nullptr;
+    const bool  valid          = JSCheckScriptSyntax(js_context_ref, script_ref, source_url_ref, 1, &exception);
+    JSStringRelease(source_url_ref);
+    JSStringRelease(script_ref);
+    if (!valid) {
+      std::string line;
+      if (exception && JSValueIsObject(js_context_ref, exception)) {
+        JSStringRef line_ref = JSStringCreateWithUTF8CString("line");
+        line = ":" + ToString(js_context_ref, JSObjectGetProperty(js_context_ref, JSValueToObject(js_context_ref, exception, nullptr), line_ref, nullptr));
+        JSStringRelease(line_ref);
+      }
+      std::cerr << name << line << ": " << (exception ? ToString(js_context_ref, exception) : "syntax error") << std::endl;
+    }
+    return valid;
+  }
+
+  void Align(std::string& bundle, std::size_t alignment) {
+    bundle.resize((bundle.size() + alignment - 1) / alignment * alignment, '\0');
+  }
+
+  // Lay out the given UTF-16 sources, keyed by name, as described in
+  // JSScriptBundleFormat.hpp.
+  std::string Pack(const std::map<std::string, std::u16string>& sources) {
+    std::string bundle(sizeof(JSScriptBundleHeader), '\0');
+    std::vector<JSScriptBundleEntry> entries;
+    for (const auto& source : sources) {
+      Align(bundle, 8);
+      JSScriptBundleEntry entry {};
+      entry.source_offset = bundle.size();
+      entry.source_length = source.second.size();
+      bundle.append(reinterpret_cast<const char*>(source.second.data()), source.second.size() * sizeof(char16_t));
+      entries.push_back(entry);
+    }
+    auto entry = entries.begin();
+    for (const auto& source : sources) {
+      entry -> name_offset = bundle.size();
+      entry -> name_size   = source.first.size();
+      bundle.append(source.first);
+      ++entry;
+    }
+    Align(bundle, alignof(JSScriptBundleEntry));
+
+    JSScriptBundleHeader header {};
+    std::copy(JSScriptBundleHeader::GetMagic(), JSScriptBundleHeader::GetMagic() + sizeof(header.magic), header.magic);
+    header.version      = JSScriptBundleHeader::kVersion;
+    header.script_count = static_cast<std::uint32_t>(entries.size());
+    header.index_offset = bundle.size();
+    bundle.append(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(JSScriptBundleEntry));
+    header.size         = bundle.size();
+    bundle.replace(0, sizeof(header), reinterpret_cast<const char*>(&header), sizeof(header));
+    return bundle;
+  }
+
+} // namespace {
+
+int main(int argc, const char* argv[]) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " <App directory> <tiapp.xml> <bundle>" << std::endl;
+    return 2;
+  }
+  const std::string app_directory = argv[1];
+  const std::string tiapp_path    = argv[2];
+  const std::string bundle_path   = argv[3];
+
+  std::map<std::string, std::string> scripts;
+  ListScripts(app_directory, "", scripts);
+
+  std::string tiapp_xml;
+  if (!ReadFile(tiapp_path, tiapp_xml)) {
+    std::cerr << tiapp_path << ": can't read" << std::endl;
+    return 1;
+  }
+  bool ok = CheckTiApp(tiapp_xml, scripts);
+
+  JSGlobalContextRef js_context_ref = JSGlobalContextCreate(nullptr);
+  std::map<std::string, std::u16string> sources;
+  for (const auto& script : scripts) {
+    std::string source;
+    if (!ReadFile(script.second, source)) {
+      std::cerr << script.second << ": can't read" << std::endl;
+      ok = false;
+      continue;
+    }
+    ok = PrepareScript(js_context_ref, script.first, std::move(source), sources[script.first]) && ok;
+  }
+  JSGlobalContextRelease(js_context_ref);
+  if (!ok) {
+    return 1;
+  }
+
+  const std::string bundle = Pack(sources);
+  const std::string error  = HAL::detail::ValidateJSScriptBundle(bundle.data(), bundle.size());
+  if (!error.empty()) {
+    std::cerr << bundle_path << ": " << error << std::endl;
+    return 1;
+  }
+
+  // Replace the bundle atomically, so that a running build never reads
+  // half of one.
+  const std::string temporary_path = bundle_path + ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!file.write(bundle.data(), bundle.size())) {
+      std::cerr << temporary_path << ": can't write" << std::endl;
+      return 1;
+    }
+  }
+  if (std::rename(temporary_path.c_str(), bundle_path.c_str()) != 0) {
+    std::cerr << bundle_path << ": can't write" << std::endl;
+    return 1;
+  }
+  std::cout << bundle_path << ": " << sources.size() << " scripts, " << bundle.size() << " bytes" << std::endl;
+  return 0;
+}
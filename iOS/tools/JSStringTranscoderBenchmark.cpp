@@ -0,0 +1,159 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+// Compare HAL::detail::JSStringTranscoder with the
+// std::wstring_convert<std::codecvt_utf8_utf16<char16_t>> conversions
+// that HAL used before it.
+//
+// Usage: JSStringTranscoderBenchmark [iterations]
+//
+// First check that both produce the same output for random valid
+// strings, then time converting ASCII, Latin-1 and CJK text of 4096
+// code units each way. Build it with optimizations and the target's
+// vector unit enabled, for example:
+//
+//   c++ -std=c++11 -O2 -I../include JSStringTranscoderBenchmark.cpp
+
+#include "HAL/detail/JSStringTranscoder.hpp"
+
+#include <chrono>
+#include <codecvt>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <random>
+#include <string>
+
+namespace {
+
+  using Converter_t = std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>;
+
+  std::string CodecvtToUTF8(const std::u16string& string) {
+    return Converter_t().to_bytes(string);
+  }
+
+  std::u16string CodecvtToUTF16(const std::string& string) {
+    return Converter_t().from_bytes(string);
+  }
+
+  void Append(std::u16string& string, std::uint32_t code_point) {
+    if (code_point >= 0x10000) {
+      code_point -= 0x10000;
+      string.push_back(static_cast<char16_t>(0xD800 + (code_point >> 10)));
+      string.push_back(static_cast<char16_t>(0xDC00 + (code_point & 0x3FF)));
+    } else {
+      string.push_back(static_cast<char16_t>(code_point));
+    }
+  }
+
+  // A random well-formed string mixing all four UTF-8 sequence
+  // lengths.
+  std::u16string MakeMixedString(std::mt19937& random, std::size_t length) {
+    std::u16string string;
+    while (string.size() < length) {
+      const auto kind = random() % 10;
+      if (kind < 5) {
+        Append(string, random() % 0x80);
+      } else if (kind < 7) {
+        Append(string, 0x80 + random() % 0x780);
+      } else if (kind < 9) {
+        std::uint32_t code_point;
+        do {
+          code_point = 0x800 + random() % 0xF800;
+        } while (code_point >= 0xD800 && code_point <= 0xDFFF);
+        Append(string, code_point);
+      } else {
+        Append(string, 0x10000 + random() % 0x100000);
+      }
+    }
+    return string;
+  }
+
+  enum class Text { ASCII, Latin1, CJK };
+
+  std::u16string MakeText(std::mt19937& random, Text text, std::size_t length) {
+    std::u16string string;
+    while (string.size() < length) {
+      switch (text) {
+        case Text::ASCII:
+          Append(string, 'a' + random() % 26);
+          break;
+        case Text::Latin1:
+          Append(string, random() % 4 ? 'a' + random() % 26 : 0xC0 + random() % 0x3F);
+          break;
+        case Text::CJK:
+          Append(string, 0x4E00 + random() % 0x5000);
+          break;
+      }
+    }
+    return string;
+  }
+
+  bool CheckOutputs(std::mt19937& random) {
+    for (int i = 0; i < 20000; ++i) {
+      const std::u16string utf16 = MakeMixedString(random, random() % 80);
+      const std::string    utf8  = HAL::detail::ToUTF8String(utf16.data(), utf16.size());
+      if (utf8 != CodecvtToUTF8(utf16)) {
+        std::fprintf(stderr, "UTF-16 to UTF-8 differs from codecvt\n");
+        return false;
+      }
+      if (HAL::detail::ToUTF16String(utf8.data(), utf8.size()) != utf16) {
+        std::fprintf(stderr, "UTF-8 to UTF-16 differs from codecvt\n");
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Return the mean time of one call to function, in microseconds.
+  template<typename Function>
+  double Time(int iterations, std::size_t& sink, Function function) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+      sink += function();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(stop - start).count() / iterations;
+  }
+
+} // namespace {
+
+int main(int argc, const char* argv[]) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+  if (iterations <= 0) {
+    std::fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+    return 2;
+  }
+
+  std::mt19937 random(1);
+  if (!CheckOutputs(random)) {
+    return 1;
+  }
+
+  std::printf("microseconds per conversion of 4096 code units\n");
+  std::printf("%-8s %26s %26s\n", "input", "UTF-16->UTF-8 codecvt/new", "UTF-8->UTF-16 codecvt/new");
+  const struct { Text text; const char* name; } inputs[] = {
+    { Text::ASCII , "ASCII"   },
+    { Text::Latin1, "Latin-1" },
+    { Text::CJK   , "CJK"     }
+  };
+  std::size_t sink = 0;
+  for (const auto& input : inputs) {
+    const std::u16string utf16 = MakeText(random, input.text, 4096);
+    const std::string    utf8  = CodecvtToUTF8(utf16);
+    const double codecvt_to_utf8  = Time(iterations, sink, [&] { return CodecvtToUTF8(utf16).size(); });
+    const double new_to_utf8      = Time(iterations, sink, [&] { return HAL::detail::ToUTF8String(utf16.data(), utf16.size()).size(); });
+    const double codecvt_to_utf16 = Time(iterations, sink, [&] { return CodecvtToUTF16(utf8).size(); });
+    const double new_to_utf16     = Time(iterations, sink, [&] { return HAL::detail::ToUTF16String(utf8.data(), utf8.size()).size(); });
+    std::printf("%-8s %12.1f / %-11.1f %12.1f / %-11.1f\n", input.name, codecvt_to_utf8, new_to_utf8, codecvt_to_utf16, new_to_utf16);
+  }
+
+  // Keep the conversions from being optimized away.
+  return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * HAL
+ *
+ * Copyright (c) 2014 by Appcelerator, Inc. All Rights Reserved.
+ * Licensed under the terms of the Apache Public License.
+ * Please see the LICENSE included with this distribution for details.
+ */
+
+// Check with the JSPerformanceCounter copy and move counters that
+// values flowing through the HAL API by rvalue are moved rather than
+// copied, so that JavaScriptCore doesn't protect and unprotect them
+// again.
+//
+// Usage: JSValueMoveCheck
+//
+// Both HAL and this tool must be built with
+// -DHAL_PERFORMANCE_COUNTER_ENABLE=1, for example:
+//
+//   c++ -std=c++11 -DHAL_PERFORMANCE_COUNTER_ENABLE=1 -I../include JSValueMoveCheck.cpp -lHAL -framework JavaScriptCore
+
+#include "HAL/HAL.hpp"
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#ifndef HAL_PERFORMANCE_COUNTER_ENABLE
+#error "Build with -DHAL_PERFORMANCE_COUNTER_ENABLE=1"
+#endif
+
+namespace {
+
+  using HAL::detail::JSPerformanceCounter;
+
+  // The copy and move constructions of T since it was created.
+  template<typename T>
+  class Counts final {
+
+  public:
+
+    Counts()
+    : copied__(JSPerformanceCounter<T>::get_objects_copy_constructed())
+    , moved__(JSPerformanceCounter<T>::get_objects_move_constructed()) {
+    }
+
+    long get_copied() const {
+      return JSPerformanceCounter<T>::get_objects_copy_constructed() - copied__;
+    }
+
+    long get_moved() const {
+      return JSPerformanceCounter<T>::get_objects_move_constructed() - moved__;
+    }
+
+  private:
+
+    long copied__;
+    long moved__;
+  };
+
+  int failures = 0;
+
+  template<typename T>
+  void Expect(const char* type_name, const char* name, const Counts<T>& counts, long copied) {
+    const bool ok = counts.get_copied() == copied;
+    std::printf("%s %-40s %s copied %ld, moved %ld\n", ok ? "ok  " : "FAIL", name, type_name, counts.get_copied(), counts.get_moved());
+    failures += ok ? 0 : 1;
+  }
+
+} // namespace {
+
+int main() {
+  HAL::JSContextGroup js_context_group;
+  HAL::JSContext      js_context = js_context_group.CreateContext();
+
+  {
+    HAL::JSValue lhs = js_context.CreateNumber(1);
+    HAL::JSValue rhs = js_context.CreateNumber(2);
+    Counts<HAL::JSValue> counts;
+    lhs = rhs;
+    Expect("JSValue", "lvalue assignment copies once", counts, 1);
+  }
+
+  {
+    HAL::JSValue lhs = js_context.CreateNumber(1);
+    HAL::JSValue rhs = js_context.CreateNumber(2);
+    Counts<HAL::JSValue> counts;
+    lhs = std::move(rhs);
+    Expect("JSValue", "rvalue assignment", counts, 0);
+  }
+
+  {
+    HAL::JSObject lhs = js_context.CreateObject();
+    HAL::JSObject rhs = js_context.CreateObject();
+    Counts<HAL::JSObject> counts;
+    lhs = std::move(rhs);
+    Expect("JSObject", "rvalue assignment", counts, 0);
+  }
+
+  {
+    Counts<HAL::JSValue> counts;
+    std::vector<HAL::JSValue> values;
+    for (int i = 0; i < 1000; ++i) {
+      values.push_back(js_context.CreateNumber(i));
+    }
+    Expect("JSValue", "std::vector growth", counts, 0);
+  }
+
+  {
+    HAL::JSObject js_object = js_context.CreateObject();
+    js_object.SetProperty("x", js_context.CreateNumber(1));
+    Counts<HAL::JSObject> counts;
+    HAL::JSPropertyView view(std::move(js_object));
+    Expect("JSObject", "JSPropertyView from an rvalue", counts, 0);
+  }
+
+  {
+    HAL::JSObject js_object = js_context.CreateObject();
+    Counts<HAL::JSObject> counts;
+    js_context.JSEvaluateScript("this", std::move(js_object));
+    Expect("JSObject", "JSEvaluateScript with an rvalue this", counts, 0);
+  }
+
+  {
+    HAL::JSArray js_array = js_context.CreateArray();
+    Counts<HAL::JSObject> counts;
+    js_context.JSEvaluateScript("this", js_array);
+    Expect("JSObject", "JSEvaluateScript with a JSArray this", counts, 0);
+  }
+
+  {
+    HAL::JSObject js_function = static_cast<HAL::JSObject>(js_context.JSEvaluateScript("(function() { return this; })"));
+    HAL::JSArray  js_array    = js_context.CreateArray();
+    Counts<HAL::JSObject> counts;
+    js_function(js_array);
+    Expect("JSObject", "operator() with a JSArray this", counts, 0);
+  }
+
+  return failures == 0 ? 0 : 1;
+}